@@ -3,6 +3,8 @@
 
 #include "iterator.h"
 #include "sort.h"
+#include "stream_store.h"
+#include "type_traits.h"
 
 namespace ministl
 {
@@ -354,6 +356,27 @@ namespace ministl
 		for (; first != end; ++first) *first = value;
 	}
 
+	template <typename T>
+	void fill_impl(T *first, T *end, const T &value, true_type)
+	{
+		if (!use_stream_store(sizeof(T) * (end - first)) || !stream_fill(first, end - first, value))
+			for (; first != end; ++first) *first = value;
+	}
+
+	template <typename T>
+	void fill_impl(T *first, T *end, const T &value, false_type)
+	{
+		for (; first != end; ++first) *first = value;
+	}
+
+	// Large arrays of POD types are filled with streaming stores, see
+	// stream_store.h.
+	template <typename T>
+	void fill(T *first, T *end, const T &value)
+	{
+		fill_impl(first, end, value, typename type_traits<T>::is_POD_type());
+	}
+
 	// Assigns the given value to the first count elements in the range beginning
 	// at first if count > 0. Does nothing otherwise
 	template <typename OutputIterator, typename Size, typename T>
@@ -366,6 +389,15 @@ namespace ministl
 		return first;
 	}
 
+	template <typename T, typename Size>
+	T *fill_n(T *first, Size count, const T &value)
+	{
+		if (count <= 0)
+			return first;
+		fill(first, first + count, value);
+		return first + count;
+	}
+
 	// Swaps the values of the elements the given iterators are pointing to.
 	template <typename ForwardIterator1, typename ForwardIterator2>
 	void iter_swap(ForwardIterator1 a, ForwardIterator2 b)
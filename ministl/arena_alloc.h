@@ -0,0 +1,266 @@
+#ifndef ARENA_ALLOC_H
+#define ARENA_ALLOC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include "type_traits.h"
+
+namespace ministl
+{
+	/// monotonic_arena
+	///
+	/// A bump pointer arena. allocate hands out the next bytes of the
+	/// current block and takes a new, twice as large block from malloc when
+	/// it runs out. Memory is never given back one allocation at a time:
+	/// reset makes everything allocated so far available again at once, and
+	/// the destructor frees the blocks. An arena may start from a buffer
+	/// owned by the caller, which is used before any block is malloc'ed.
+	class monotonic_arena
+	{
+	public:
+		explicit monotonic_arena(size_t initial_size = 4096);
+		monotonic_arena(void *buffer, size_t size);
+		~monotonic_arena();
+
+		void *allocate(size_t n, size_t align = alignof(std::max_align_t));
+		void  reset();
+
+		size_t bytes_allocated()const;
+
+	private:
+		struct block
+		{
+			block  *mpNext;
+			size_t  mSize;
+		};
+
+		monotonic_arena(const monotonic_arena&);
+		monotonic_arena &operator=(const monotonic_arena&);
+
+		void *allocate_from_new_block(size_t n, size_t align);
+		void  free_blocks(block *pKeep);
+
+	private:
+		char   *mpBuffer;
+		size_t  mBufferSize;
+		block  *mpBlocks;
+		char   *mpCurrent;
+		char   *mpEnd;
+		size_t  mNextSize;
+		size_t  mAllocated;
+	};
+
+
+	/// arena_allocator
+	///
+	/// Lets a container take its nodes from a monotonic_arena. Copies of an
+	/// arena_allocator share the same arena, and deallocate does nothing, so
+	/// list and forward_list skip the per node free walk when they are
+	/// cleared or destroyed. A default constructed arena_allocator has no
+	/// arena and must be replaced with set_allocator before it allocates.
+	///
+	///     monotonic_arena arena;
+	///     list<int, arena_allocator> l{arena_allocator(arena)};
+	///     ... use l, let it go out of scope ...
+	///     arena.reset();
+	class arena_allocator
+	{
+	public:
+		arena_allocator();
+		arena_allocator(monotonic_arena &arena);
+
+		void *allocate(size_t n);
+		void *allocate_batch(size_t n, size_t count);
+		void  deallocate(void *p, size_t n);
+		void  reset();
+
+		monotonic_arena *arena()const;
+
+	private:
+		monotonic_arena *mpArena;
+	};
+
+	template <>
+	struct allocator_traits<arena_allocator>
+	{
+		typedef true_type has_trivial_deallocate;
+		typedef true_type has_batch_allocate;
+	};
+
+	bool operator==(const arena_allocator &lhs, const arena_allocator &rhs);
+	bool operator!=(const arena_allocator &lhs, const arena_allocator &rhs);
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// monotonic_arena
+	///////////////////////////////////////////////////////////////////////
+
+	inline monotonic_arena::monotonic_arena(size_t initial_size)
+		: mpBuffer(nullptr),
+		  mBufferSize(0),
+		  mpBlocks(nullptr),
+		  mpCurrent(nullptr),
+		  mpEnd(nullptr),
+		  mNextSize(initial_size),
+		  mAllocated(0)
+	{
+		// empty
+	}
+
+	inline monotonic_arena::monotonic_arena(void *buffer, size_t size)
+		: mpBuffer(static_cast<char*>(buffer)),
+		  mBufferSize(size),
+		  mpBlocks(nullptr),
+		  mpCurrent(static_cast<char*>(buffer)),
+		  mpEnd(static_cast<char*>(buffer) + size),
+		  mNextSize(size ? size * 2 : 4096),
+		  mAllocated(0)
+	{
+		// empty
+	}
+
+	inline monotonic_arena::~monotonic_arena()
+	{
+		free_blocks(nullptr);
+	}
+
+	inline void *monotonic_arena::allocate(size_t n, size_t align)
+	{
+		uintptr_t current = reinterpret_cast<uintptr_t>(mpCurrent);
+		char *result = reinterpret_cast<char*>((current + align - 1) & ~(static_cast<uintptr_t>(align) - 1));
+
+		if (!mpCurrent || result + n > mpEnd)
+			return allocate_from_new_block(n, align);
+
+		mpCurrent = result + n;
+		mAllocated += n;
+		return result;
+	}
+
+	// makes all the memory of the arena available again. The caller's
+	// buffer, or else the newest (largest) block, becomes the current one,
+	// and the other blocks are freed.
+	inline void monotonic_arena::reset()
+	{
+		if (mpBuffer)
+		{
+			free_blocks(nullptr);
+			mpCurrent = mpBuffer;
+			mpEnd = mpBuffer + mBufferSize;
+		}
+		else if (mpBlocks)
+		{
+			free_blocks(mpBlocks);
+			mpCurrent = reinterpret_cast<char*>(mpBlocks + 1);
+			mpEnd = reinterpret_cast<char*>(mpBlocks) + mpBlocks->mSize;
+		}
+
+		mAllocated = 0;
+	}
+
+	inline size_t monotonic_arena::bytes_allocated()const
+	{
+		return mAllocated;
+	}
+
+	inline void *monotonic_arena::allocate_from_new_block(size_t n, size_t align)
+	{
+		size_t size = mNextSize;
+		while (size < sizeof(block) + align + n)
+			size *= 2;
+
+		block *pBlock = static_cast<block*>(std::malloc(size));
+		if (!pBlock)
+			throw std::bad_alloc();
+
+		pBlock->mpNext = mpBlocks;
+		pBlock->mSize = size;
+		mpBlocks = pBlock;
+		mNextSize = size * 2;
+
+		mpCurrent = reinterpret_cast<char*>(pBlock + 1);
+		mpEnd = reinterpret_cast<char*>(pBlock) + size;
+		return allocate(n, align);
+	}
+
+	// frees every block but pKeep, which is left as the only one.
+	inline void monotonic_arena::free_blocks(block *pKeep)
+	{
+		block *pBlock = mpBlocks;
+		while (pBlock)
+		{
+			block *pNext = pBlock->mpNext;
+			if (pBlock != pKeep)
+				std::free(pBlock);
+			pBlock = pNext;
+		}
+
+		mpBlocks = pKeep;
+		if (pKeep)
+			pKeep->mpNext = nullptr;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// arena_allocator
+	///////////////////////////////////////////////////////////////////////
+
+	inline arena_allocator::arena_allocator()
+		: mpArena(nullptr)
+	{
+		// empty
+	}
+
+	inline arena_allocator::arena_allocator(monotonic_arena &arena)
+		: mpArena(&arena)
+	{
+		// empty
+	}
+
+	inline void *arena_allocator::allocate(size_t n)
+	{
+		return mpArena->allocate(n);
+	}
+
+	// bumps the arena once for the whole run, see allocator_traits.
+	inline void *arena_allocator::allocate_batch(size_t n, size_t count)
+	{
+		if (count == 0)
+			return nullptr;
+
+		char *p = static_cast<char*>(mpArena->allocate(n * count));
+		for (size_t i = 1; i < count; ++i, p += n)
+			*reinterpret_cast<void**>(p) = p + n;
+		*reinterpret_cast<void**>(p) = nullptr;
+		return p - (count - 1) * n;
+	}
+
+	inline void arena_allocator::deallocate(void*, size_t)
+	{
+		// empty, memory comes back with monotonic_arena::reset
+	}
+
+	inline void arena_allocator::reset()
+	{
+		mpArena->reset();
+	}
+
+	inline monotonic_arena *arena_allocator::arena()const
+	{
+		return mpArena;
+	}
+
+	inline bool operator==(const arena_allocator &lhs, const arena_allocator &rhs)
+	{
+		return lhs.arena() == rhs.arena();
+	}
+
+	inline bool operator!=(const arena_allocator &lhs, const arena_allocator &rhs)
+	{
+		return lhs.arena() != rhs.arena();
+	}
+}
+
+#endif
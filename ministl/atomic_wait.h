@@ -0,0 +1,135 @@
+#ifndef ATOMIC_WAIT_H
+#define ATOMIC_WAIT_H
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define MINISTL_HAS_FUTEX 1
+#else
+#define MINISTL_HAS_FUTEX 0
+#endif
+
+namespace ministl
+{
+	/// Helpers for the concurrent queues: how far apart to keep data written
+	/// by different threads, how to spin, and how to park a thread until a
+	/// 32 bit word changes. Parking uses the futex system call on Linux,
+	/// std::atomic::wait where the library has it, and otherwise degrades
+	/// to yielding the processor.
+
+	enum
+	{
+		__CACHE_LINE_SIZE = 64,
+
+		// how many times a blocking operation retries before it parks.
+		__SPIN_COUNT = 128
+	};
+
+	// tells the processor this is a spin loop, so that it backs off a
+	// little and does not starve its hyperthread sibling.
+	inline void cpu_relax()
+	{
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+		__builtin_ia32_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+		__asm__ __volatile__("yield");
+#else
+		std::this_thread::yield();
+#endif
+	}
+
+	// blocks while word holds expected. It may also return spuriously, so
+	// it is always called in a loop that checks the condition again.
+	inline void atomic_wait(std::atomic<uint32_t> &word, uint32_t expected)
+	{
+#if MINISTL_HAS_FUTEX
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected,
+		        nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+		word.wait(expected, std::memory_order_acquire);
+#else
+		if (word.load(std::memory_order_acquire) == expected)
+			std::this_thread::yield();
+#endif
+	}
+
+	// wakes every thread blocked in atomic_wait on word.
+	inline void atomic_notify_all(std::atomic<uint32_t> &word)
+	{
+#if MINISTL_HAS_FUTEX
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX,
+		        nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+		word.notify_all();
+#else
+		(void)word;
+#endif
+	}
+
+
+	/// parking_lot
+	///
+	/// Lets threads sleep until another thread reports progress, at the cost
+	/// of a fence and a load for the reporting thread while nobody sleeps.
+	///
+	/// A waiter calls prepare_wait, checks its condition once more and, if
+	/// it still does not hold, calls wait with the value prepare_wait
+	/// returned, then cancel_wait. The thread that makes the condition true
+	/// calls notify afterwards. The seq_cst fences on both sides make sure
+	/// that either the waiter sees the change or the notifier sees the
+	/// waiter, so no wake up is lost. The epoch is bumped with release and
+	/// read with acquire, so that a waiter that sees a new epoch also sees
+	/// what the notifier wrote before it.
+	class parking_lot
+	{
+	public:
+		parking_lot()
+			: mEpoch(0),
+			  mWaiters(0)
+		{
+			// empty
+		}
+
+		uint32_t prepare_wait()
+		{
+			mWaiters.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			return mEpoch.load(std::memory_order_acquire);
+		}
+
+		void wait(uint32_t epoch)
+		{
+			atomic_wait(mEpoch, epoch);
+		}
+
+		void cancel_wait()
+		{
+			mWaiters.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		void notify()
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (mWaiters.load(std::memory_order_relaxed) != 0)
+			{
+				mEpoch.fetch_add(1, std::memory_order_release);
+				atomic_notify_all(mEpoch);
+			}
+		}
+
+		parking_lot(const parking_lot&) = delete;
+		parking_lot &operator=(const parking_lot&) = delete;
+
+	private:
+		std::atomic<uint32_t> mEpoch;
+		std::atomic<uint32_t> mWaiters;
+	};
+}
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef CHUNK_SOURCE_H
+#define CHUNK_SOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define MINISTL_HAS_MMAP 1
+#define MINISTL_HAS_POSIX_MEMALIGN 1
+#else
+#define MINISTL_HAS_MMAP 0
+#define MINISTL_HAS_POSIX_MEMALIGN 0
+#endif
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace ministl
+{
+	enum
+	{
+		// chunks are aligned to, and sized in multiples of, 1 << __CHUNK_SHIFT
+		// bytes so that the page map can find the chunk of any node.
+		__CHUNK_SHIFT = 16
+	};
+
+	enum
+	{
+		__HUGE_PAGE_SHIFT = 21
+	};
+
+	/// A chunk source is where __default_allocator gets the large blocks it
+	/// carves nodes from. It is a class with
+	///
+	///     static const size_t granularity;
+	///     static void *allocate(size_t size);
+	///     static void  deallocate(void *p, size_t size);
+	///
+	/// allocate is only called with multiples of granularity, which itself
+	/// is a multiple of 1 << __CHUNK_SHIFT. It returns memory aligned to
+	/// granularity, or a null pointer when it runs out. deallocate gets the
+	/// same size back.
+
+
+	/// malloc_chunk_source
+	///
+	/// Takes chunks from the C heap with its aligned allocation call, which
+	/// gives the unaligned ends back to the heap instead of keeping a
+	/// granule of slack with every chunk. Where there is none, a granule
+	/// more is taken from malloc, and the pointer it returned is kept right
+	/// before the chunk.
+	struct malloc_chunk_source
+	{
+		static const size_t granularity = static_cast<size_t>(1) << __CHUNK_SHIFT;
+
+		static void *allocate(size_t size)
+		{
+#if MINISTL_HAS_POSIX_MEMALIGN
+			void *p;
+			if (posix_memalign(&p, granularity, size) != 0)
+				return nullptr;
+			return p;
+#elif defined(_WIN32)
+			return _aligned_malloc(size, granularity);
+#else
+			char *raw = static_cast<char*>(std::malloc(size + granularity + sizeof(void*)));
+			if (!raw)
+				return nullptr;
+
+			uintptr_t first = reinterpret_cast<uintptr_t>(raw + sizeof(void*));
+			char *base = reinterpret_cast<char*>((first + granularity - 1) & ~(granularity - 1));
+			reinterpret_cast<char**>(base)[-1] = raw;
+			return base;
+#endif
+		}
+
+		static void deallocate(void *p, size_t)
+		{
+#if MINISTL_HAS_POSIX_MEMALIGN
+			std::free(p);
+#elif defined(_WIN32)
+			_aligned_free(p);
+#else
+			std::free(static_cast<char**>(p)[-1]);
+#endif
+		}
+	};
+
+
+#if MINISTL_HAS_MMAP
+	/// mmap_chunk_source
+	///
+	/// Maps chunks directly, in multiples of 2 MB aligned to 2 MB, and asks
+	/// the kernel to back them with transparent huge pages where it can
+	/// (MADV_HUGEPAGE). Large pools of list nodes then need far fewer TLB
+	/// entries to traverse.
+	struct mmap_chunk_source
+	{
+		static const size_t granularity = static_cast<size_t>(1) << __HUGE_PAGE_SHIFT;
+
+		static void *allocate(size_t size)
+		{
+			// map one granule more than needed and cut the unaligned ends
+			// off, munmap works on any page boundary.
+			char *raw = static_cast<char*>(mmap(nullptr, size + granularity, PROT_READ | PROT_WRITE,
+			                                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+			if (raw == MAP_FAILED)
+				return nullptr;
+
+			char *base = reinterpret_cast<char*>(
+				(reinterpret_cast<uintptr_t>(raw) + granularity - 1) & ~(granularity - 1));
+			if (base != raw)
+				munmap(raw, base - raw);
+			if (base + size != raw + size + granularity)
+				munmap(base + size, raw + size + granularity - (base + size));
+
+#ifdef MADV_HUGEPAGE
+			madvise(base, size, MADV_HUGEPAGE);
+#endif
+			return base;
+		}
+
+		static void deallocate(void *p, size_t size)
+		{
+			munmap(p, size);
+		}
+	};
+
+
+	/// hugetlb_chunk_source
+	///
+	/// Maps chunks from the explicitly reserved huge page pool (MAP_HUGETLB),
+	/// which never falls back to small pages behind our back. When the pool
+	/// is empty, or the platform has no MAP_HUGETLB, it falls back to
+	/// mmap_chunk_source. Both kinds of mapping are released with munmap.
+	struct hugetlb_chunk_source
+	{
+		static const size_t granularity = static_cast<size_t>(1) << __HUGE_PAGE_SHIFT;
+
+		static void *allocate(size_t size)
+		{
+#ifdef MAP_HUGETLB
+			void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+			               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (p != MAP_FAILED)
+				return p;
+#endif
+			return mmap_chunk_source::allocate(size);
+		}
+
+		static void deallocate(void *p, size_t size)
+		{
+			munmap(p, size);
+		}
+	};
+#endif
+}
+
+#endif
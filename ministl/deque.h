@@ -0,0 +1,1082 @@
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+#include "allocator.h"
+#include "iterator.h"
+#include "type_traits.h"
+#include "uninitialized.h"
+
+namespace ministl
+{
+	/// deque_block_size
+	///
+	/// The default number of elements per block of a deque: as many as fit
+	/// in 4096 bytes, the largest size class of the pools, but at least 16.
+	template <typename T>
+	struct deque_block_size
+	{
+		enum
+		{
+			value = sizeof(T) < 256 ? 4096 / sizeof(T) : 16
+		};
+	};
+
+	enum
+	{
+		// the number of emptied blocks a deque keeps for reuse.
+		__DEQUE_SPARE_BLOCKS = 4,
+		__DEQUE_MIN_MAP_SIZE = 8
+	};
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	struct DequeIterator
+	{
+		typedef ptrdiff_t                                            difference_type;
+		typedef T                                                    value_type;
+		typedef Pointer                                              pointer;
+		typedef Reference                                            reference;
+		typedef random_access_iterator_tag                           iterator_category;
+		typedef DequeIterator<T, T&, T*, BlockSize>                  iterator;
+		typedef DequeIterator<T, const T&, const T*, BlockSize>      const_iterator;
+		typedef DequeIterator                                        this_type;
+
+		DequeIterator();
+		DequeIterator(const iterator &it);
+
+		// the constructor above is the copy constructor of iterator, which
+		// would leave its implicit assignment deprecated.
+		this_type &operator=(const this_type &it) = default;
+
+		this_type &operator++();
+		this_type  operator++(int);
+		this_type &operator--();
+		this_type  operator--(int);
+		this_type &operator+=(difference_type n);
+		this_type &operator-=(difference_type n);
+		this_type  operator+(difference_type n)const;
+		this_type  operator-(difference_type n)const;
+		reference  operator[](difference_type n)const;
+		reference  operator*()const;
+		pointer    operator->()const;
+
+		void SetBlock(T **pBlock);
+
+		T  *mpCurrent;
+		T  *mpBegin;
+		T  *mpEnd;
+		T **mpBlock;
+	};
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	class DequeBase
+	{
+	public:
+		typedef ptrdiff_t                                       difference_type;
+		typedef size_t                                          size_type;
+		typedef Allocator                                       allocator_type;
+		typedef DequeIterator<T, T&, T*, BlockSize>             iterator;
+
+		const allocator_type &get_allocator()const;
+		allocator_type       &get_allocator();
+		void                  set_allocator(const allocator_type &alloc);
+
+	protected:
+		DequeBase(const allocator_type &alloc);
+		~DequeBase();
+
+		T   *AllocateBlock();
+		void FreeBlock(T *pBlock);
+		void FreeSpareBlocks();
+		T  **AllocateMap(size_type n);
+		void FreeMap(T **pMap, size_type n);
+
+		void InitMap(size_type n);
+		void ReserveMapAtBack(size_type n = 1);
+		void ReserveMapAtFront(size_type n = 1);
+		void ReallocateMap(size_type n, bool at_front);
+
+	protected:
+		T             **mpMap;
+		size_type       mMapSize;
+		iterator        mItBegin;
+		iterator        mItEnd;
+		allocator_type  mAllocator;
+		T              *mpSpareBlocks[__DEQUE_SPARE_BLOCKS];
+		size_type       mSpareCount;
+	};
+
+
+	/// deque
+	///
+	/// A double ended queue made of blocks of BlockSize elements, with a map
+	/// of pointers to them. The blocks come from Allocator, and by default
+	/// fit in the pools of sub_alloc.h.
+	///
+	/// A block emptied at either end is not given back right away: up to
+	/// __DEQUE_SPARE_BLOCKS of them are kept, and the next block needed at
+	/// either end is one of them. When the blocks in use reach an end of the
+	/// map, they are moved back to its middle as long as the map is less than
+	/// half full, and only otherwise is the map reallocated. A deque used as
+	/// a FIFO of steady size therefore stops allocating once it is warm.
+	/// shrink_to_fit gives the spare blocks back.
+	template <typename T, typename Allocator = alloc, size_t BlockSize = deque_block_size<T>::value>
+	class deque: public DequeBase<T, Allocator, BlockSize>
+	{
+		typedef DequeBase<T, Allocator, BlockSize>                  base_type;
+		typedef deque<T, Allocator, BlockSize>                      this_type;
+
+	public:
+		typedef T                                                   value_type;
+		typedef T*                                                  pointer;
+		typedef const T*                                            const_pointer;
+		typedef T&                                                  reference;
+		typedef const T&                                            const_reference;
+		typedef DequeIterator<T, T&, T*, BlockSize>                 iterator;
+		typedef DequeIterator<T, const T&, const T*, BlockSize>     const_iterator;
+		typedef ministl::reverse_iterator<iterator>                 reverse_iterator;
+		typedef ministl::reverse_iterator<const_iterator>           const_reverse_iterator;
+		typedef typename base_type::size_type                       size_type;
+		typedef typename base_type::difference_type                 difference_type;
+		typedef typename base_type::allocator_type                  allocator_type;
+
+		using base_type::mpMap;
+		using base_type::mMapSize;
+		using base_type::mItBegin;
+		using base_type::mItEnd;
+		using base_type::mAllocator;
+		using base_type::AllocateBlock;
+		using base_type::FreeBlock;
+		using base_type::FreeSpareBlocks;
+		using base_type::InitMap;
+		using base_type::ReserveMapAtBack;
+		using base_type::ReserveMapAtFront;
+		using base_type::get_allocator;
+
+	public:
+		deque();
+		deque(const allocator_type &alloc);
+		explicit deque(size_type n, const allocator_type &alloc = Allocator());
+		deque(size_type n, const value_type &value, const allocator_type &alloc = Allocator());
+		deque(const this_type &other);
+		deque(this_type &&other);
+		deque(std::initializer_list<T> ilist, const allocator_type &alloc = Allocator());
+		~deque();
+
+		this_type &operator=(const this_type &other);
+		this_type &operator=(this_type &&other);
+
+		reference       at(size_type i);
+		const_reference at(size_type i)const;
+		reference       operator[](size_type i);
+		const_reference operator[](size_type i)const;
+
+		reference       front();
+		const_reference front()const;
+		reference       back();
+		const_reference back()const;
+
+		iterator               begin();
+		const_iterator         begin()const;
+		const_iterator         cbegin()const;
+		iterator               end();
+		const_iterator         end()const;
+		const_iterator         cend()const;
+		reverse_iterator       rbegin();
+		const_reverse_iterator rbegin()const;
+		reverse_iterator       rend();
+		const_reverse_iterator rend()const;
+
+		bool      empty()const;
+		size_type size()const;
+		void      shrink_to_fit();
+
+		void      clear();
+		void      push_back(const T &value);
+		void      push_back(T &&value);
+		void      push_front(const T &value);
+		void      push_front(T &&value);
+		template <typename...Args>
+		reference emplace_back(Args&&...args);
+		template <typename...Args>
+		reference emplace_front(Args&&...args);
+		void      pop_back();
+		void      pop_front();
+		void      resize(size_type n);
+		void      resize(size_type n, const T &value);
+		void      swap(this_type &other);
+
+	protected:
+		void FillBlocks(const T &value);
+		void DestroyElements();
+	};
+
+
+	////////////////////////////////////////
+	// DequeIterator
+	////////////////////////////////////////
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	DequeIterator<T, Reference, Pointer, BlockSize>::DequeIterator()
+		: mpCurrent(nullptr),
+		  mpBegin(nullptr),
+		  mpEnd(nullptr),
+		  mpBlock(nullptr)
+	{
+		// empty
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	DequeIterator<T, Reference, Pointer, BlockSize>::DequeIterator(const iterator &it)
+		: mpCurrent(it.mpCurrent),
+		  mpBegin(it.mpBegin),
+		  mpEnd(it.mpEnd),
+		  mpBlock(it.mpBlock)
+	{
+		// empty
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	inline typename DequeIterator<T, Reference, Pointer, BlockSize>::this_type&
+	DequeIterator<T, Reference, Pointer, BlockSize>::operator++()
+	{
+		if (++mpCurrent == mpEnd)
+		{
+			SetBlock(mpBlock + 1);
+			mpCurrent = mpBegin;
+		}
+		return *this;
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	inline typename DequeIterator<T, Reference, Pointer, BlockSize>::this_type
+	DequeIterator<T, Reference, Pointer, BlockSize>::operator++(int)
+	{
+		this_type temp(*this);
+		++*this;
+		return temp;
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	inline typename DequeIterator<T, Reference, Pointer, BlockSize>::this_type&
+	DequeIterator<T, Reference, Pointer, BlockSize>::operator--()
+	{
+		if (mpCurrent == mpBegin)
+		{
+			SetBlock(mpBlock - 1);
+			mpCurrent = mpEnd;
+		}
+		--mpCurrent;
+		return *this;
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	inline typename DequeIterator<T, Reference, Pointer, BlockSize>::this_type
+	DequeIterator<T, Reference, Pointer, BlockSize>::operator--(int)
+	{
+		this_type temp(*this);
+		--*this;
+		return temp;
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	typename DequeIterator<T, Reference, Pointer, BlockSize>::this_type&
+	DequeIterator<T, Reference, Pointer, BlockSize>::operator+=(difference_type n)
+	{
+		const difference_type block_size = BlockSize;
+		difference_type offset = n + (mpCurrent - mpBegin);
+
+		if (offset >= 0 && offset < block_size)
+			mpCurrent += n;
+		else
+		{
+			difference_type block_offset = offset > 0 ? offset / block_size
+			                                          : -((-offset - 1) / block_size) - 1;
+			SetBlock(mpBlock + block_offset);
+			mpCurrent = mpBegin + (offset - block_offset * block_size);
+		}
+		return *this;
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	inline typename DequeIterator<T, Reference, Pointer, BlockSize>::this_type&
+	DequeIterator<T, Reference, Pointer, BlockSize>::operator-=(difference_type n)
+	{
+		return *this += -n;
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	inline typename DequeIterator<T, Reference, Pointer, BlockSize>::this_type
+	DequeIterator<T, Reference, Pointer, BlockSize>::operator+(difference_type n)const
+	{
+		this_type temp(*this);
+		return temp += n;
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	inline typename DequeIterator<T, Reference, Pointer, BlockSize>::this_type
+	DequeIterator<T, Reference, Pointer, BlockSize>::operator-(difference_type n)const
+	{
+		this_type temp(*this);
+		return temp -= n;
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	inline typename DequeIterator<T, Reference, Pointer, BlockSize>::reference
+	DequeIterator<T, Reference, Pointer, BlockSize>::operator[](difference_type n)const
+	{
+		return *(*this + n);
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	inline typename DequeIterator<T, Reference, Pointer, BlockSize>::reference
+	DequeIterator<T, Reference, Pointer, BlockSize>::operator*()const
+	{
+		return *mpCurrent;
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	inline typename DequeIterator<T, Reference, Pointer, BlockSize>::pointer
+	DequeIterator<T, Reference, Pointer, BlockSize>::operator->()const
+	{
+		return mpCurrent;
+	}
+
+
+	template <typename T, typename Reference, typename Pointer, size_t BlockSize>
+	inline void DequeIterator<T, Reference, Pointer, BlockSize>::SetBlock(T **pBlock)
+	{
+		mpBlock = pBlock;
+		mpBegin = *pBlock;
+		mpEnd = mpBegin + BlockSize;
+	}
+
+
+	template <typename T, typename RefA, typename PtrA, typename RefB, typename PtrB, size_t BlockSize>
+	inline ptrdiff_t operator-(const DequeIterator<T, RefA, PtrA, BlockSize> &lhs,
+	                           const DequeIterator<T, RefB, PtrB, BlockSize> &rhs)
+	{
+		return static_cast<ptrdiff_t>(BlockSize) * (lhs.mpBlock - rhs.mpBlock - 1)
+		       + (lhs.mpCurrent - lhs.mpBegin) + (rhs.mpEnd - rhs.mpCurrent);
+	}
+
+
+	template <typename T, typename RefA, typename PtrA, typename RefB, typename PtrB, size_t BlockSize>
+	inline bool operator==(const DequeIterator<T, RefA, PtrA, BlockSize> &lhs,
+	                       const DequeIterator<T, RefB, PtrB, BlockSize> &rhs)
+	{
+		return lhs.mpCurrent == rhs.mpCurrent;
+	}
+
+
+	template <typename T, typename RefA, typename PtrA, typename RefB, typename PtrB, size_t BlockSize>
+	inline bool operator!=(const DequeIterator<T, RefA, PtrA, BlockSize> &lhs,
+	                       const DequeIterator<T, RefB, PtrB, BlockSize> &rhs)
+	{
+		return lhs.mpCurrent != rhs.mpCurrent;
+	}
+
+
+	template <typename T, typename RefA, typename PtrA, typename RefB, typename PtrB, size_t BlockSize>
+	inline bool operator<(const DequeIterator<T, RefA, PtrA, BlockSize> &lhs,
+	                      const DequeIterator<T, RefB, PtrB, BlockSize> &rhs)
+	{
+		return lhs.mpBlock == rhs.mpBlock ? lhs.mpCurrent < rhs.mpCurrent : lhs.mpBlock < rhs.mpBlock;
+	}
+
+
+	////////////////////////////////////////
+	// DequeBase
+	////////////////////////////////////////
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	DequeBase<T, Allocator, BlockSize>::DequeBase(const allocator_type &alloc)
+		: mpMap(nullptr),
+		  mMapSize(0),
+		  mItBegin(),
+		  mItEnd(),
+		  mAllocator(alloc),
+		  mSpareCount(0)
+	{
+		// empty
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	DequeBase<T, Allocator, BlockSize>::~DequeBase()
+	{
+		if (mpMap)
+		{
+			for (T **pBlock = mItBegin.mpBlock; pBlock <= mItEnd.mpBlock; ++pBlock)
+				FreeBlock(*pBlock);
+			FreeMap(mpMap, mMapSize);
+		}
+		FreeSpareBlocks();
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	const typename DequeBase<T, Allocator, BlockSize>::allocator_type&
+	DequeBase<T, Allocator, BlockSize>::get_allocator()const
+	{
+		return mAllocator;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	typename DequeBase<T, Allocator, BlockSize>::allocator_type&
+	DequeBase<T, Allocator, BlockSize>::get_allocator()
+	{
+		return mAllocator;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	void DequeBase<T, Allocator, BlockSize>::set_allocator(const allocator_type &alloc)
+	{
+		mAllocator = alloc;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	T *DequeBase<T, Allocator, BlockSize>::AllocateBlock()
+	{
+		if (mSpareCount > 0)
+			return mpSpareBlocks[--mSpareCount];
+		return (T*)allocate_memory(mAllocator, BlockSize * sizeof(T));
+	}
+
+
+	// keeps the block for reuse while there is room for it.
+	template <typename T, typename Allocator, size_t BlockSize>
+	void DequeBase<T, Allocator, BlockSize>::FreeBlock(T *pBlock)
+	{
+		if (mSpareCount < __DEQUE_SPARE_BLOCKS)
+			mpSpareBlocks[mSpareCount++] = pBlock;
+		else
+			MINISTLFree(mAllocator, pBlock, BlockSize * sizeof(T));
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	void DequeBase<T, Allocator, BlockSize>::FreeSpareBlocks()
+	{
+		while (mSpareCount > 0)
+			MINISTLFree(mAllocator, mpSpareBlocks[--mSpareCount], BlockSize * sizeof(T));
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	T **DequeBase<T, Allocator, BlockSize>::AllocateMap(size_type n)
+	{
+		return (T**)allocate_memory(mAllocator, n * sizeof(T*));
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	void DequeBase<T, Allocator, BlockSize>::FreeMap(T **pMap, size_type n)
+	{
+		MINISTLFree(mAllocator, pMap, n * sizeof(T*));
+	}
+
+
+	// sets up a map with the blocks for n elements in its middle, the
+	// elements themselves are left unconstructed.
+	template <typename T, typename Allocator, size_t BlockSize>
+	void DequeBase<T, Allocator, BlockSize>::InitMap(size_type n)
+	{
+		size_type n_blocks = n / BlockSize + 1;
+		mMapSize = n_blocks + 2;
+		if (mMapSize < static_cast<size_type>(__DEQUE_MIN_MAP_SIZE))
+			mMapSize = __DEQUE_MIN_MAP_SIZE;
+		mpMap = AllocateMap(mMapSize);
+
+		T **pBegin = mpMap + (mMapSize - n_blocks) / 2;
+		T **pEnd = pBegin + n_blocks;
+		T **pBlock = pBegin;
+		try
+		{
+			for (; pBlock != pEnd; ++pBlock)
+				*pBlock = AllocateBlock();
+		}
+		catch (...)
+		{
+			while (pBlock != pBegin)
+				FreeBlock(*--pBlock);
+			FreeMap(mpMap, mMapSize);
+			mpMap = nullptr;
+			throw;
+		}
+
+		mItBegin.SetBlock(pBegin);
+		mItBegin.mpCurrent = mItBegin.mpBegin;
+		mItEnd.SetBlock(pEnd - 1);
+		mItEnd.mpCurrent = mItEnd.mpBegin + n % BlockSize;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline void DequeBase<T, Allocator, BlockSize>::ReserveMapAtBack(size_type n)
+	{
+		if (n + 1 > mMapSize - (mItEnd.mpBlock - mpMap))
+			ReallocateMap(n, false);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline void DequeBase<T, Allocator, BlockSize>::ReserveMapAtFront(size_type n)
+	{
+		if (n > size_type(mItBegin.mpBlock - mpMap))
+			ReallocateMap(n, true);
+	}
+
+
+	// makes room for n more block pointers at one end of the map. While
+	// the map is less than half full, the blocks in use are only moved back
+	// to its middle.
+	template <typename T, typename Allocator, size_t BlockSize>
+	void DequeBase<T, Allocator, BlockSize>::ReallocateMap(size_type n, bool at_front)
+	{
+		size_type n_old_blocks = mItEnd.mpBlock - mItBegin.mpBlock + 1;
+		size_type n_new_blocks = n_old_blocks + n;
+		T **pNewBegin;
+
+		if (mMapSize > 2 * n_new_blocks)
+		{
+			pNewBegin = mpMap + (mMapSize - n_new_blocks) / 2 + (at_front ? n : 0);
+			std::memmove(pNewBegin, mItBegin.mpBlock, n_old_blocks * sizeof(T*));
+		}
+		else
+		{
+			size_type new_map_size = mMapSize + (mMapSize > n ? mMapSize : n) + 2;
+			T **pNewMap = AllocateMap(new_map_size);
+			pNewBegin = pNewMap + (new_map_size - n_new_blocks) / 2 + (at_front ? n : 0);
+			std::memcpy(pNewBegin, mItBegin.mpBlock, n_old_blocks * sizeof(T*));
+			FreeMap(mpMap, mMapSize);
+			mpMap = pNewMap;
+			mMapSize = new_map_size;
+		}
+
+		mItBegin.SetBlock(pNewBegin);
+		mItEnd.SetBlock(pNewBegin + n_old_blocks - 1);
+	}
+
+
+	////////////////////////////////////////
+	// deque
+	////////////////////////////////////////
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	deque<T, Allocator, BlockSize>::deque()
+		: base_type(Allocator())
+	{
+		InitMap(0);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	deque<T, Allocator, BlockSize>::deque(const allocator_type &alloc)
+		: base_type(alloc)
+	{
+		InitMap(0);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	deque<T, Allocator, BlockSize>::deque(size_type n, const allocator_type &alloc)
+		: base_type(alloc)
+	{
+		InitMap(0);
+		resize(n);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	deque<T, Allocator, BlockSize>::deque(size_type n, const value_type &value, const allocator_type &alloc)
+		: base_type(alloc)
+	{
+		InitMap(n);
+		FillBlocks(value);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	deque<T, Allocator, BlockSize>::deque(const this_type &other)
+		: base_type(other.mAllocator)
+	{
+		InitMap(0);
+		for (const_iterator it = other.begin(); it != other.end(); ++it)
+			emplace_back(*it);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	deque<T, Allocator, BlockSize>::deque(this_type &&other)
+		: base_type(other.mAllocator)
+	{
+		InitMap(0);
+		swap(other);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	deque<T, Allocator, BlockSize>::deque(std::initializer_list<T> ilist, const allocator_type &alloc)
+		: base_type(alloc)
+	{
+		InitMap(0);
+		for (const T *p = ilist.begin(); p != ilist.end(); ++p)
+			emplace_back(*p);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	deque<T, Allocator, BlockSize>::~deque()
+	{
+		DestroyElements();
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	typename deque<T, Allocator, BlockSize>::this_type&
+	deque<T, Allocator, BlockSize>::operator=(const this_type &other)
+	{
+		if (this != &other)
+		{
+			clear();
+			for (const_iterator it = other.begin(); it != other.end(); ++it)
+				emplace_back(*it);
+		}
+		return *this;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	typename deque<T, Allocator, BlockSize>::this_type&
+	deque<T, Allocator, BlockSize>::operator=(this_type &&other)
+	{
+		if (this != &other)
+		{
+			clear();
+			swap(other);
+		}
+		return *this;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::reference
+	deque<T, Allocator, BlockSize>::at(size_type i)
+	{
+		if (i >= size())
+			throw std::out_of_range("deque::at(size_type i) out of range");
+		return mItBegin[i];
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::const_reference
+	deque<T, Allocator, BlockSize>::at(size_type i)const
+	{
+		if (i >= size())
+			throw std::out_of_range("deque::at(size_type i) out of range");
+		return mItBegin[i];
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::reference
+	deque<T, Allocator, BlockSize>::operator[](size_type i)
+	{
+		return mItBegin[i];
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::const_reference
+	deque<T, Allocator, BlockSize>::operator[](size_type i)const
+	{
+		return mItBegin[i];
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::reference
+	deque<T, Allocator, BlockSize>::front()
+	{
+		return *mItBegin;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::const_reference
+	deque<T, Allocator, BlockSize>::front()const
+	{
+		return *mItBegin;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::reference
+	deque<T, Allocator, BlockSize>::back()
+	{
+		iterator it(mItEnd);
+		return *--it;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::const_reference
+	deque<T, Allocator, BlockSize>::back()const
+	{
+		iterator it(mItEnd);
+		return *--it;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::iterator
+	deque<T, Allocator, BlockSize>::begin()
+	{
+		return mItBegin;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::const_iterator
+	deque<T, Allocator, BlockSize>::begin()const
+	{
+		return mItBegin;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::const_iterator
+	deque<T, Allocator, BlockSize>::cbegin()const
+	{
+		return mItBegin;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::iterator
+	deque<T, Allocator, BlockSize>::end()
+	{
+		return mItEnd;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::const_iterator
+	deque<T, Allocator, BlockSize>::end()const
+	{
+		return mItEnd;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::const_iterator
+	deque<T, Allocator, BlockSize>::cend()const
+	{
+		return mItEnd;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::reverse_iterator
+	deque<T, Allocator, BlockSize>::rbegin()
+	{
+		return reverse_iterator(mItEnd);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::const_reverse_iterator
+	deque<T, Allocator, BlockSize>::rbegin()const
+	{
+		return const_reverse_iterator(mItEnd);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::reverse_iterator
+	deque<T, Allocator, BlockSize>::rend()
+	{
+		return reverse_iterator(mItBegin);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::const_reverse_iterator
+	deque<T, Allocator, BlockSize>::rend()const
+	{
+		return const_reverse_iterator(mItBegin);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline bool deque<T, Allocator, BlockSize>::empty()const
+	{
+		return mItBegin == mItEnd;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::size_type
+	deque<T, Allocator, BlockSize>::size()const
+	{
+		return mItEnd - mItBegin;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::shrink_to_fit()
+	{
+		FreeSpareBlocks();
+	}
+
+
+	// keeps the first block, the others become spares or are freed.
+	template <typename T, typename Allocator, size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::clear()
+	{
+		DestroyElements();
+		for (T **pBlock = mItBegin.mpBlock + 1; pBlock <= mItEnd.mpBlock; ++pBlock)
+			FreeBlock(*pBlock);
+		mItEnd = mItBegin;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline void deque<T, Allocator, BlockSize>::push_back(const T &value)
+	{
+		emplace_back(value);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline void deque<T, Allocator, BlockSize>::push_back(T &&value)
+	{
+		emplace_back(std::move(value));
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline void deque<T, Allocator, BlockSize>::push_front(const T &value)
+	{
+		emplace_front(value);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	inline void deque<T, Allocator, BlockSize>::push_front(T &&value)
+	{
+		emplace_front(std::move(value));
+	}
+
+
+	// the end iterator always points into a block, so the next block is
+	// taken as soon as the last slot of the current one is filled.
+	template <typename T, typename Allocator, size_t BlockSize>
+	template <typename...Args>
+	typename deque<T, Allocator, BlockSize>::reference
+	deque<T, Allocator, BlockSize>::emplace_back(Args&&...args)
+	{
+		if (mItEnd.mpCurrent != mItEnd.mpEnd - 1)
+		{
+			::new(static_cast<void*>(mItEnd.mpCurrent)) value_type(std::forward<Args>(args)...);
+			return *mItEnd.mpCurrent++;
+		}
+
+		ReserveMapAtBack();
+		mItEnd.mpBlock[1] = AllocateBlock();
+		try
+		{
+			::new(static_cast<void*>(mItEnd.mpCurrent)) value_type(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			FreeBlock(mItEnd.mpBlock[1]);
+			throw;
+		}
+		T *pValue = mItEnd.mpCurrent;
+		mItEnd.SetBlock(mItEnd.mpBlock + 1);
+		mItEnd.mpCurrent = mItEnd.mpBegin;
+		return *pValue;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	template <typename...Args>
+	typename deque<T, Allocator, BlockSize>::reference
+	deque<T, Allocator, BlockSize>::emplace_front(Args&&...args)
+	{
+		if (mItBegin.mpCurrent != mItBegin.mpBegin)
+		{
+			::new(static_cast<void*>(mItBegin.mpCurrent - 1)) value_type(std::forward<Args>(args)...);
+			return *--mItBegin.mpCurrent;
+		}
+
+		ReserveMapAtFront();
+		mItBegin.mpBlock[-1] = AllocateBlock();
+		try
+		{
+			::new(static_cast<void*>(mItBegin.mpBlock[-1] + BlockSize - 1)) value_type(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			FreeBlock(mItBegin.mpBlock[-1]);
+			throw;
+		}
+		mItBegin.SetBlock(mItBegin.mpBlock - 1);
+		mItBegin.mpCurrent = mItBegin.mpEnd - 1;
+		return *mItBegin.mpCurrent;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::pop_back()
+	{
+		if (mItEnd.mpCurrent == mItEnd.mpBegin)
+		{
+			FreeBlock(mItEnd.mpBegin);
+			mItEnd.SetBlock(mItEnd.mpBlock - 1);
+			mItEnd.mpCurrent = mItEnd.mpEnd;
+		}
+		--mItEnd.mpCurrent;
+		mItEnd.mpCurrent->~value_type();
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::pop_front()
+	{
+		mItBegin.mpCurrent->~value_type();
+		if (++mItBegin.mpCurrent == mItBegin.mpEnd)
+		{
+			FreeBlock(mItBegin.mpBegin);
+			mItBegin.SetBlock(mItBegin.mpBlock + 1);
+			mItBegin.mpCurrent = mItBegin.mpBegin;
+		}
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::resize(size_type n)
+	{
+		while (size() > n)
+			pop_back();
+		while (size() < n)
+			emplace_back();
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::resize(size_type n, const T &value)
+	{
+		while (size() > n)
+			pop_back();
+		while (size() < n)
+			emplace_back(value);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::swap(this_type &other)
+	{
+		std::swap(mpMap, other.mpMap);
+		std::swap(mMapSize, other.mMapSize);
+		std::swap(mItBegin, other.mItBegin);
+		std::swap(mItEnd, other.mItEnd);
+		std::swap(mAllocator, other.mAllocator);
+		std::swap(this->mpSpareBlocks, other.mpSpareBlocks);
+		std::swap(this->mSpareCount, other.mSpareCount);
+	}
+
+
+	// constructs the elements of a fresh map from InitMap, one block at a
+	// time with uninitialized_fill_n. When that throws, every block but the
+	// first is given back, leaving an empty deque.
+	template <typename T, typename Allocator, size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::FillBlocks(const T &value)
+	{
+		T **pBlock = mItBegin.mpBlock;
+		try
+		{
+			for (; pBlock < mItEnd.mpBlock; ++pBlock)
+				ministl::uninitialized_fill_n(*pBlock, BlockSize, value);
+			ministl::uninitialized_fill_n(mItEnd.mpBegin, mItEnd.mpCurrent - mItEnd.mpBegin, value);
+		}
+		catch (...)
+		{
+			for (T **pDone = mItBegin.mpBlock; pDone < pBlock; ++pDone)
+				ministl::destroy(*pDone, *pDone + BlockSize);
+			for (T **pFree = mItBegin.mpBlock + 1; pFree <= mItEnd.mpBlock; ++pFree)
+				FreeBlock(*pFree);
+			mItEnd = mItBegin;
+			throw;
+		}
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::DestroyElements()
+	{
+		if (mItBegin.mpBlock == mItEnd.mpBlock)
+			ministl::destroy(mItBegin.mpCurrent, mItEnd.mpCurrent);
+		else
+		{
+			ministl::destroy(mItBegin.mpCurrent, mItBegin.mpEnd);
+			for (T **pBlock = mItBegin.mpBlock + 1; pBlock < mItEnd.mpBlock; ++pBlock)
+				ministl::destroy(*pBlock, *pBlock + BlockSize);
+			ministl::destroy(mItEnd.mpBegin, mItEnd.mpCurrent);
+		}
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	bool operator==(const deque<T, Allocator, BlockSize> &lhs, const deque<T, Allocator, BlockSize> &rhs)
+	{
+		if (lhs.size() != rhs.size())
+			return false;
+		typename deque<T, Allocator, BlockSize>::const_iterator it = rhs.begin();
+		for (typename deque<T, Allocator, BlockSize>::const_iterator jt = lhs.begin(); jt != lhs.end(); ++jt, ++it)
+		{
+			if (!(*jt == *it))
+				return false;
+		}
+		return true;
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	bool operator!=(const deque<T, Allocator, BlockSize> &lhs, const deque<T, Allocator, BlockSize> &rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+
+	template <typename T, typename Allocator, size_t BlockSize>
+	void swap(deque<T, Allocator, BlockSize> &lhs, deque<T, Allocator, BlockSize> &rhs)
+	{
+		lhs.swap(rhs);
+	}
+}
+
+#endif
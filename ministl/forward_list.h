@@ -87,8 +87,16 @@ namespace ministl
 
 		node_type *AllocateNode();
 		void       FreeNode(node_type *pNode);
+		void      *AllocateNodes(size_type n);
+		void       FreeNodes(void *pRun);
 		ForwardListNodeBase *EraseAfter(ForwardListNodeBase *pNode);
 		ForwardListNodeBase *EraseAfter(ForwardListNodeBase *pNode, ForwardListNodeBase *pLast);
+
+		void Clear();
+		void Clear(false_type);
+		void Clear(true_type);
+		void DestroyValues(false_type);
+		void DestroyValues(true_type);
 	};
 
 	template <typename T, typename Allocator = alloc>
@@ -117,8 +125,11 @@ namespace ministl
 		using base_type::mAllocator;
 		using base_type::AllocateNode;
 		using base_type::FreeNode;
+		using base_type::AllocateNodes;
+		using base_type::FreeNodes;
 		using base_type::get_allocator;
 		using base_type::EraseAfter;
+		using base_type::Clear;
 
 	public:
 		forward_list();
@@ -200,10 +211,20 @@ namespace ministl
 
 		node_type *InsertValueAfter(ForwardListNodeBase *p, const T &value);
 		node_type *InsertValuesAfter(ForwardListNodeBase *p, size_type count, const T &value);
+		node_type *InsertValuesAfter(ForwardListNodeBase *p, size_type count, const T &value, false_type);
+		node_type *InsertValuesAfter(ForwardListNodeBase *p, size_type count, const T &value, true_type);
 		template <typename Integer>
 		node_type *InsertAfter(ForwardListNodeBase *node, Integer n, Integer value, true_type);
 		template <typename InputIterator>
 		node_type *InsertAfter(ForwardListNodeBase *node, InputIterator first, InputIterator last, false_type);
+		template <typename InputIterator>
+		node_type *InsertRangeAfter(ForwardListNodeBase *node, InputIterator first, InputIterator last, false_type);
+		template <typename InputIterator>
+		node_type *InsertRangeAfter(ForwardListNodeBase *node, InputIterator first, InputIterator last, true_type);
+		template <typename InputIterator>
+		node_type *InsertRangeAfter(ForwardListNodeBase *node, InputIterator first, InputIterator last, input_iterator_tag);
+		template <typename ForwardIterator>
+		node_type *InsertRangeAfter(ForwardListNodeBase *node, ForwardIterator first, ForwardIterator last, forward_iterator_tag);
 
 		void AssignValues(size_type count, const T &value);
 		template <typename Integer>
@@ -387,7 +408,7 @@ namespace ministl
 	template <typename T, typename Allocator>
 	ForwardListBase<T, Allocator>::~ForwardListBase()
 	{
-		EraseAfter(&mNode, nullptr);
+		Clear();
 	}
 
 	template <typename T, typename Allocator>
@@ -424,6 +445,26 @@ namespace ministl
 		MINISTLFree(mAllocator, pNode, sizeof(node_type));
 	}
 
+	// only for allocators with has_batch_allocate, returns a run of n
+	// nodes linked through their first word, see allocator_traits.
+	template <typename T, typename Allocator>
+	inline void *ForwardListBase<T, Allocator>::AllocateNodes(size_type n)
+	{
+		return mAllocator.allocate_batch(sizeof(node_type), n);
+	}
+
+	// frees the nodes of a run that were not constructed.
+	template <typename T, typename Allocator>
+	void ForwardListBase<T, Allocator>::FreeNodes(void *pRun)
+	{
+		while (pRun)
+		{
+			void *pNext = *static_cast<void**>(pRun);
+			MINISTLFree(mAllocator, pRun, sizeof(node_type));
+			pRun = pNext;
+		}
+	}
+
 	template <typename T, typename Allocator>
 	inline ForwardListNodeBase*
 	ForwardListBase<T, Allocator>::EraseAfter(ForwardListNodeBase *pNode)
@@ -447,6 +488,47 @@ namespace ministl
 		return pLast;
 	}
 
+	// removes all the nodes. When the allocator does nothing on deallocate
+	// the nodes are not handed back, and the list is not even walked when T
+	// needs no destructor.
+	template <typename T, typename Allocator>
+	inline void ForwardListBase<T, Allocator>::Clear()
+	{
+		Clear(typename allocator_traits<Allocator>::has_trivial_deallocate());
+	}
+
+	template <typename T, typename Allocator>
+	inline void ForwardListBase<T, Allocator>::Clear(false_type)
+	{
+		EraseAfter(&mNode, nullptr);
+	}
+
+	template <typename T, typename Allocator>
+	inline void ForwardListBase<T, Allocator>::Clear(true_type)
+	{
+		DestroyValues(typename type_traits<T>::is_trivially_destructible());
+		mNode.mpNext = nullptr;
+	}
+
+	template <typename T, typename Allocator>
+	void ForwardListBase<T, Allocator>::DestroyValues(false_type)
+	{
+		ForwardListNodeBase *pNode = mNode.mpNext;
+
+		while (pNode)
+		{
+			ForwardListNodeBase *temp = pNode->mpNext;
+			static_cast<node_type*>(pNode)->~node_type();
+			pNode = temp;
+		}
+	}
+
+	template <typename T, typename Allocator>
+	inline void ForwardListBase<T, Allocator>::DestroyValues(true_type)
+	{
+		// empty
+	}
+
 
 	///////////////////////////////////////////////////////////////////////
 	/// forward_list
@@ -631,7 +713,7 @@ namespace ministl
 	template <typename T, typename Allocator>
 	void forward_list<T, Allocator>::clear()
 	{
-		EraseAfter(&mNode, nullptr);
+		Clear();
 	}
 
 	template <typename T, typename Allocator>
@@ -939,12 +1021,49 @@ namespace ministl
 	template <typename T, typename Allocator>
 	typename forward_list<T, Allocator>::node_type*
 	forward_list<T, Allocator>::InsertValuesAfter(ForwardListNodeBase *pNode, size_type n, const T &value)
+	{
+		return InsertValuesAfter(pNode, n, value, typename allocator_traits<Allocator>::has_batch_allocate());
+	}
+
+	template <typename T, typename Allocator>
+	typename forward_list<T, Allocator>::node_type*
+	forward_list<T, Allocator>::InsertValuesAfter(ForwardListNodeBase *pNode, size_type n, const T &value, false_type)
 	{
 		for (; n > 0; --n)
 			pNode = InsertValueAfter(pNode, value);
 		return static_cast<node_type*>(pNode);
 	}
 
+	// takes all n nodes from the allocator at once, so they lie next to
+	// each other in the order they are linked.
+	template <typename T, typename Allocator>
+	typename forward_list<T, Allocator>::node_type*
+	forward_list<T, Allocator>::InsertValuesAfter(ForwardListNodeBase *pNode, size_type n, const T &value, true_type)
+	{
+		if (n == 0)
+			return static_cast<node_type*>(pNode);
+
+		void *pRun = AllocateNodes(n);
+		try
+		{
+			while (pRun)
+			{
+				node_type *pNewNode = static_cast<node_type*>(pRun);
+				void *pNext = *static_cast<void**>(pRun);
+				new(&pNewNode->mValue)value_type(value);
+				pRun = pNext;
+				ForwardListInsertAfter(pNode, pNewNode);
+				pNode = pNewNode;
+			}
+		}
+		catch (...)
+		{
+			FreeNodes(pRun);
+			throw;
+		}
+		return static_cast<node_type*>(pNode);
+	}
+
 	template <typename T, typename Allocator>
 	template <typename Integer>
 	typename forward_list<T, Allocator>::node_type*
@@ -957,12 +1076,68 @@ namespace ministl
 	template <typename InputIterator>
 	typename forward_list<T, Allocator>::node_type*
 	forward_list<T, Allocator>::InsertAfter(ForwardListNodeBase *pNode, InputIterator first, InputIterator last, false_type)
+	{
+		return InsertRangeAfter(pNode, first, last, typename allocator_traits<Allocator>::has_batch_allocate());
+	}
+
+	template <typename T, typename Allocator>
+	template <typename InputIterator>
+	typename forward_list<T, Allocator>::node_type*
+	forward_list<T, Allocator>::InsertRangeAfter(ForwardListNodeBase *pNode, InputIterator first, InputIterator last, false_type)
 	{
 		for (; first != last; ++first)
 			pNode = InsertValueAfter(pNode, *first);
 		return static_cast<node_type*>(pNode);
 	}
 
+	template <typename T, typename Allocator>
+	template <typename InputIterator>
+	typename forward_list<T, Allocator>::node_type*
+	forward_list<T, Allocator>::InsertRangeAfter(ForwardListNodeBase *pNode, InputIterator first, InputIterator last, true_type)
+	{
+		return InsertRangeAfter(pNode, first, last, typename iterator_traits<InputIterator>::iterator_category());
+	}
+
+	template <typename T, typename Allocator>
+	template <typename InputIterator>
+	typename forward_list<T, Allocator>::node_type*
+	forward_list<T, Allocator>::InsertRangeAfter(ForwardListNodeBase *pNode, InputIterator first, InputIterator last, input_iterator_tag)
+	{
+		return InsertRangeAfter(pNode, first, last, false_type());
+	}
+
+	// a forward range can be counted first, and then all its nodes are
+	// taken from the allocator at once.
+	template <typename T, typename Allocator>
+	template <typename ForwardIterator>
+	typename forward_list<T, Allocator>::node_type*
+	forward_list<T, Allocator>::InsertRangeAfter(ForwardListNodeBase *pNode, ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+	{
+		size_type n = static_cast<size_type>(ministl::distance(first, last));
+		if (n == 0)
+			return static_cast<node_type*>(pNode);
+
+		void *pRun = AllocateNodes(n);
+		try
+		{
+			for (; first != last; ++first)
+			{
+				node_type *pNewNode = static_cast<node_type*>(pRun);
+				void *pNext = *static_cast<void**>(pRun);
+				new(&pNewNode->mValue)value_type(*first);
+				pRun = pNext;
+				ForwardListInsertAfter(pNode, pNewNode);
+				pNode = pNewNode;
+			}
+		}
+		catch (...)
+		{
+			FreeNodes(pRun);
+			throw;
+		}
+		return static_cast<node_type*>(pNode);
+	}
+
 	template <typename T, typename Allocator>
 	void forward_list<T, Allocator>::AssignValues(size_type n, const T &value)
 	{
@@ -1,6 +1,8 @@
 #ifndef UNORDERED_SET_H
 #define UNORDERED_SET_H
 
+#include "vector.h"
+
 namespace ministl
 {
 	/// HashSetNode
@@ -115,7 +117,7 @@ namespace ministl
 		typedef ptrdiff_t difference_type;
 
 	protected:
-		std::vector<node_type*> mBucketTable;
+		vector<node_type*, Allocator> mBucketTable;
 		size_type               mSize;
 		allocator_type          mAllocator;
 
@@ -0,0 +1,590 @@
+#ifndef HUGE_ARRAY_H
+#define HUGE_ARRAY_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "chunk_source.h"
+#include "iterator.h"
+#include "type_traits.h"
+#include "uninitialized.h"
+
+#if MINISTL_HAS_MMAP
+#include <unistd.h>
+#endif
+
+namespace ministl
+{
+	/// huge_array
+	///
+	/// A growable array for buffers of many gigabytes. Its storage is mapped
+	/// directly with mmap, bypassing the pools, and grows with
+	/// mremap(MREMAP_MAYMOVE): the kernel moves page table entries instead
+	/// of the bytes, so growing costs the same at any size and never needs
+	/// the old and the new buffer at once. Where there is no mremap, the
+	/// array moves to a new mapping with memcpy; without mmap at all it
+	/// uses realloc.
+	///
+	/// Moving the bytes of the elements behind their back is only sound for
+	/// trivially relocatable types (see type_traits.h), so huge_array does
+	/// not compile for other types. Fresh pages are zero filled, and resize
+	/// does not initialize the elements of a POD type that land on pages
+	/// never written before, so those are only touched once they are used.
+	template <typename T>
+	class huge_array
+	{
+		typedef huge_array<T> this_type;
+
+	public:
+		typedef T                                         value_type;
+		typedef T*                                        pointer;
+		typedef const T*                                  const_pointer;
+		typedef T&                                        reference;
+		typedef const T&                                  const_reference;
+		typedef T*                                        iterator;
+		typedef const T*                                  const_iterator;
+		typedef ministl::reverse_iterator<iterator>       reverse_iterator;
+		typedef ministl::reverse_iterator<const_iterator> const_reverse_iterator;
+		typedef size_t                                    size_type;
+		typedef ptrdiff_t                                 difference_type;
+
+	public:
+		huge_array();
+		explicit huge_array(size_type n);
+		huge_array(size_type n, const value_type &value);
+		huge_array(this_type &&other);
+		~huge_array();
+
+		this_type &operator=(this_type &&other);
+
+		reference       at(size_type i);
+		const_reference at(size_type i)const;
+		reference       operator[](size_type i);
+		const_reference operator[](size_type i)const;
+
+		reference       front();
+		const_reference front()const;
+		reference       back();
+		const_reference back()const;
+
+		T*       data();
+		const T* data()const;
+
+		iterator               begin();
+		const_iterator         begin()const;
+		iterator               end();
+		const_iterator         end()const;
+		reverse_iterator       rbegin();
+		const_reverse_iterator rbegin()const;
+		reverse_iterator       rend();
+		const_reverse_iterator rend()const;
+
+		bool      empty()const;
+		size_type size()const;
+		size_type capacity()const;
+		void      reserve(size_type n);
+		void      shrink_to_fit();
+
+		void clear();
+		void push_back(const T &value);
+		void push_back(T &&value);
+		template <typename...Args>
+		reference emplace_back(Args&&...args);
+		void pop_back();
+		void resize(size_type n);
+		void resize(size_type n, const T &value);
+		void swap(this_type &other);
+
+	private:
+		huge_array(const this_type&);
+		this_type &operator=(const this_type&);
+
+		static void      RequireTriviallyRelocatable(true_type);
+		static size_type PageSize();
+		static size_type RoundToPages(size_type bytes);
+
+		void Remap(size_type bytes);
+		void Grow(size_type n);
+		void ValueConstruct(T *first, T *last, true_type);
+		void ValueConstruct(T *first, T *last, false_type);
+
+	private:
+		T         *mpBegin;
+		size_type  mSize;
+		size_type  mBytes;
+		size_type  mHighWater;
+	};
+
+
+	template <typename T>
+	huge_array<T>::huge_array()
+		: mpBegin(nullptr),
+		  mSize(0),
+		  mBytes(0),
+		  mHighWater(0)
+	{
+		RequireTriviallyRelocatable(is_trivially_relocatable<T>());
+	}
+
+
+	template <typename T>
+	huge_array<T>::huge_array(size_type n)
+		: mpBegin(nullptr),
+		  mSize(0),
+		  mBytes(0),
+		  mHighWater(0)
+	{
+		RequireTriviallyRelocatable(is_trivially_relocatable<T>());
+		resize(n);
+	}
+
+
+	template <typename T>
+	huge_array<T>::huge_array(size_type n, const value_type &value)
+		: mpBegin(nullptr),
+		  mSize(0),
+		  mBytes(0),
+		  mHighWater(0)
+	{
+		RequireTriviallyRelocatable(is_trivially_relocatable<T>());
+		resize(n, value);
+	}
+
+
+	template <typename T>
+	huge_array<T>::huge_array(this_type &&other)
+		: mpBegin(nullptr),
+		  mSize(0),
+		  mBytes(0),
+		  mHighWater(0)
+	{
+		swap(other);
+	}
+
+
+	template <typename T>
+	huge_array<T>::~huge_array()
+	{
+		clear();
+		Remap(0);
+	}
+
+
+	template <typename T>
+	typename huge_array<T>::this_type&
+	huge_array<T>::operator=(this_type &&other)
+	{
+		if (this != &other)
+		{
+			this_type temp(std::move(other));
+			swap(temp);
+		}
+		return *this;
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::reference
+	huge_array<T>::at(size_type i)
+	{
+		if (i >= mSize)
+			throw std::out_of_range("huge_array::at(size_type i) out of range");
+		return mpBegin[i];
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::const_reference
+	huge_array<T>::at(size_type i)const
+	{
+		if (i >= mSize)
+			throw std::out_of_range("huge_array::at(size_type i) out of range");
+		return mpBegin[i];
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::reference
+	huge_array<T>::operator[](size_type i)
+	{
+		return mpBegin[i];
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::const_reference
+	huge_array<T>::operator[](size_type i)const
+	{
+		return mpBegin[i];
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::reference
+	huge_array<T>::front()
+	{
+		return mpBegin[0];
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::const_reference
+	huge_array<T>::front()const
+	{
+		return mpBegin[0];
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::reference
+	huge_array<T>::back()
+	{
+		return mpBegin[mSize - 1];
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::const_reference
+	huge_array<T>::back()const
+	{
+		return mpBegin[mSize - 1];
+	}
+
+
+	template <typename T>
+	inline T *huge_array<T>::data()
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T>
+	inline const T *huge_array<T>::data()const
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::iterator
+	huge_array<T>::begin()
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::const_iterator
+	huge_array<T>::begin()const
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::iterator
+	huge_array<T>::end()
+	{
+		return mpBegin + mSize;
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::const_iterator
+	huge_array<T>::end()const
+	{
+		return mpBegin + mSize;
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::reverse_iterator
+	huge_array<T>::rbegin()
+	{
+		return reverse_iterator(end());
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::const_reverse_iterator
+	huge_array<T>::rbegin()const
+	{
+		return const_reverse_iterator(end());
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::reverse_iterator
+	huge_array<T>::rend()
+	{
+		return reverse_iterator(begin());
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::const_reverse_iterator
+	huge_array<T>::rend()const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+
+	template <typename T>
+	inline bool huge_array<T>::empty()const
+	{
+		return mSize == 0;
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::size_type
+	huge_array<T>::size()const
+	{
+		return mSize;
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::size_type
+	huge_array<T>::capacity()const
+	{
+		return mBytes / sizeof(T);
+	}
+
+
+	template <typename T>
+	void huge_array<T>::reserve(size_type n)
+	{
+		if (n > capacity())
+			Remap(RoundToPages(n * sizeof(T)));
+	}
+
+
+	// gives back the pages past the last element.
+	template <typename T>
+	void huge_array<T>::shrink_to_fit()
+	{
+		size_type bytes = RoundToPages(mSize * sizeof(T));
+		if (bytes < mBytes)
+			Remap(bytes);
+	}
+
+
+	template <typename T>
+	void huge_array<T>::clear()
+	{
+		ministl::destroy(mpBegin, mpBegin + mSize);
+		mSize = 0;
+	}
+
+
+	template <typename T>
+	inline void huge_array<T>::push_back(const T &value)
+	{
+		emplace_back(value);
+	}
+
+
+	template <typename T>
+	inline void huge_array<T>::push_back(T &&value)
+	{
+		emplace_back(std::move(value));
+	}
+
+
+	// the element is constructed before the array grows, so args may refer
+	// to an element of the array.
+	template <typename T>
+	template <typename...Args>
+	typename huge_array<T>::reference
+	huge_array<T>::emplace_back(Args&&...args)
+	{
+		if (mSize == capacity())
+		{
+			value_type temp(std::forward<Args>(args)...);
+			Grow(mSize + 1);
+			::new(static_cast<void*>(mpBegin + mSize)) value_type(std::move(temp));
+		}
+		else
+			::new(static_cast<void*>(mpBegin + mSize)) value_type(std::forward<Args>(args)...);
+		if (++mSize > mHighWater)
+			mHighWater = mSize;
+		return mpBegin[mSize - 1];
+	}
+
+
+	template <typename T>
+	inline void huge_array<T>::pop_back()
+	{
+		mpBegin[--mSize].~value_type();
+	}
+
+
+	template <typename T>
+	void huge_array<T>::resize(size_type n)
+	{
+		if (n > mSize)
+		{
+			Grow(n);
+			ValueConstruct(mpBegin + mSize, mpBegin + n, typename type_traits<T>::is_POD_type());
+		}
+		else
+			ministl::destroy(mpBegin + n, mpBegin + mSize);
+		mSize = n;
+		if (mSize > mHighWater)
+			mHighWater = mSize;
+	}
+
+
+	template <typename T>
+	void huge_array<T>::resize(size_type n, const T &value)
+	{
+		if (n > mSize)
+		{
+			value_type copy(value);
+			Grow(n);
+			ministl::uninitialized_fill_n(mpBegin + mSize, n - mSize, copy);
+		}
+		else
+			ministl::destroy(mpBegin + n, mpBegin + mSize);
+		mSize = n;
+		if (mSize > mHighWater)
+			mHighWater = mSize;
+	}
+
+
+	template <typename T>
+	void huge_array<T>::swap(this_type &other)
+	{
+		std::swap(mpBegin, other.mpBegin);
+		std::swap(mSize, other.mSize);
+		std::swap(mBytes, other.mBytes);
+		std::swap(mHighWater, other.mHighWater);
+	}
+
+
+	// only declared for true_type: a huge_array of a type that is not
+	// trivially relocatable fails to compile here.
+	template <typename T>
+	inline void huge_array<T>::RequireTriviallyRelocatable(true_type)
+	{
+		// empty
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::size_type
+	huge_array<T>::PageSize()
+	{
+#if MINISTL_HAS_MMAP
+		static const size_type page_size = sysconf(_SC_PAGESIZE);
+		return page_size;
+#else
+		return 4096;
+#endif
+	}
+
+
+	template <typename T>
+	inline typename huge_array<T>::size_type
+	huge_array<T>::RoundToPages(size_type bytes)
+	{
+		size_type page_size = PageSize();
+		return (bytes + page_size - 1) & ~(page_size - 1);
+	}
+
+
+	// resizes the mapping to bytes, a multiple of the page size, keeping
+	// its contents up to the smaller of the two sizes. 0 unmaps it.
+	template <typename T>
+	void huge_array<T>::Remap(size_type bytes)
+	{
+		if (bytes == mBytes)
+			return;
+
+#if MINISTL_HAS_MMAP
+		void *p;
+		if (bytes == 0)
+		{
+			munmap(mpBegin, mBytes);
+			p = nullptr;
+		}
+		else if (mBytes == 0)
+		{
+			p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == MAP_FAILED)
+				throw std::bad_alloc();
+		}
+		else
+		{
+#ifdef MREMAP_MAYMOVE
+			p = mremap(mpBegin, mBytes, bytes, MREMAP_MAYMOVE);
+			if (p == MAP_FAILED)
+				throw std::bad_alloc();
+#else
+			p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == MAP_FAILED)
+				throw std::bad_alloc();
+			std::memcpy(p, mpBegin, mSize * sizeof(T));
+			munmap(mpBegin, mBytes);
+#endif
+		}
+
+#ifdef MADV_HUGEPAGE
+		if (bytes >= static_cast<size_type>(1) << __HUGE_PAGE_SHIFT)
+			madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+#else
+		void *p = std::realloc(mpBegin, bytes);
+		if (!p && bytes > 0)
+			throw std::bad_alloc();
+		if (bytes > mBytes)
+			std::memset(static_cast<char*>(p) + mBytes, 0, bytes - mBytes);
+#endif
+
+		mpBegin = static_cast<T*>(p);
+		mBytes = bytes;
+		if (mHighWater > capacity())
+			mHighWater = capacity();
+	}
+
+
+	// makes room for n elements. The capacity at least doubles, which costs
+	// nothing but address space.
+	template <typename T>
+	void huge_array<T>::Grow(size_type n)
+	{
+		if (n <= capacity())
+			return;
+
+		size_type bytes = mBytes * 2;
+		if (bytes < n * sizeof(T))
+			bytes = n * sizeof(T);
+		Remap(RoundToPages(bytes));
+	}
+
+
+	// value initialized PODs are zero, and the pages past the high water
+	// mark are still zero from the kernel, so only the elements below it
+	// are cleared. As with uninitialized_value_construct, a POD holding a
+	// pointer to a data member is not zero, and would come out wrong.
+	template <typename T>
+	inline void huge_array<T>::ValueConstruct(T *first, T *last, true_type)
+	{
+		T *pTouched = mpBegin + mHighWater;
+		if (first < pTouched)
+			std::memset(static_cast<void*>(first), 0, ((last < pTouched ? last : pTouched) - first) * sizeof(T));
+	}
+
+
+	template <typename T>
+	inline void huge_array<T>::ValueConstruct(T *first, T *last, false_type)
+	{
+		ministl::uninitialized_value_construct(first, last);
+	}
+}
+
+#endif
@@ -80,9 +80,15 @@ namespace ministl
 
 		node_type *AllocateNode();
 		void       FreeNode(node_type *pNode);
+		void      *AllocateNodes(size_type n);
+		void       FreeNodes(void *pRun);
 
 		void Init();
 		void Clear();
+		void Clear(false_type);
+		void Clear(true_type);
+		void DestroyValues(false_type);
+		void DestroyValues(true_type);
 
 	protected:
 		base_node_type mNode;
@@ -117,6 +123,8 @@ namespace ministl
 		using base_type::mAllocator;
 		using base_type::AllocateNode;
 		using base_type::FreeNode;
+		using base_type::AllocateNodes;
+		using base_type::FreeNodes;
 		using base_type::Clear;
 		using base_type::Init;
 		using base_type::get_allocator;
@@ -168,7 +176,7 @@ namespace ministl
 		void clear();
 		iterator insert(const_iterator pos, const T &value);
 		iterator insert(const_iterator pos, T&& value);
-		iterator insert(const_iterator pos, size_type mSize, const T &value);
+		iterator insert(const_iterator pos, size_type n, const T &value);
 		template <typename InputIterator>
 		iterator insert(const_iterator pos, InputIterator first, InputIterator last);
 		iterator insert(const_iterator pos, std::initializer_list<T> ilist);
@@ -224,12 +232,28 @@ namespace ministl
 
 		void InsertValues(ListNodeBase *pNode, size_type count, const T &value);
 
+		void InsertValues(ListNodeBase *pNode, size_type count, const T &value, false_type);
+
+		void InsertValues(ListNodeBase *pNode, size_type count, const T &value, true_type);
+
 		template <typename Integer>
 		void Insert(ListNodeBase *pNode, Integer n, Integer value, true_type);
 
 		template <typename InputIterator>
 		void Insert(ListNodeBase *pNode, InputIterator first, InputIterator last, false_type);
 
+		template <typename InputIterator>
+		void InsertRange(ListNodeBase *pNode, InputIterator first, InputIterator last, false_type);
+
+		template <typename InputIterator>
+		void InsertRange(ListNodeBase *pNode, InputIterator first, InputIterator last, true_type);
+
+		template <typename InputIterator>
+		void InsertRange(ListNodeBase *pNode, InputIterator first, InputIterator last, input_iterator_tag);
+
+		template <typename ForwardIterator>
+		void InsertRange(ListNodeBase *pNode, ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+
 		void Erase(node_type *pNode);
 	};
 
@@ -453,6 +477,28 @@ namespace ministl
 	}
 
 
+	// only for allocators with has_batch_allocate, returns a run of n
+	// nodes linked through their first word, see allocator_traits.
+	template <typename T, typename Allocator>
+	void *ListBase<T, Allocator>::AllocateNodes(size_type n)
+	{
+		return mAllocator.allocate_batch(sizeof(node_type), n);
+	}
+
+
+	// frees the nodes of a run that were not constructed.
+	template <typename T, typename Allocator>
+	void ListBase<T, Allocator>::FreeNodes(void *pRun)
+	{
+		while (pRun)
+		{
+			void *pNext = *static_cast<void**>(pRun);
+			MINISTLFree(mAllocator, pRun, sizeof(node_type));
+			pRun = pNext;
+		}
+	}
+
+
 	template <typename T, typename Allocator>
 	void ListBase<T, Allocator>::Init()
 	{
@@ -463,6 +509,13 @@ namespace ministl
 
 	template <typename T, typename Allocator>
 	void ListBase<T, Allocator>::Clear()
+	{
+		Clear(typename allocator_traits<Allocator>::has_trivial_deallocate());
+	}
+
+
+	template <typename T, typename Allocator>
+	void ListBase<T, Allocator>::Clear(false_type)
 	{
 		node_type *pNode = static_cast<node_type*>(mNode.mpNext);
 
@@ -476,6 +529,36 @@ namespace ministl
 	}
 
 
+	// the allocator does nothing on deallocate, so nodes are not handed
+	// back, and the list is not even walked when T needs no destructor.
+	template <typename T, typename Allocator>
+	void ListBase<T, Allocator>::Clear(true_type)
+	{
+		DestroyValues(typename type_traits<T>::is_trivially_destructible());
+	}
+
+
+	template <typename T, typename Allocator>
+	void ListBase<T, Allocator>::DestroyValues(false_type)
+	{
+		node_type *pNode = static_cast<node_type*>(mNode.mpNext);
+
+		while (pNode != &mNode)
+		{
+			node_type *temp = static_cast<node_type*>(pNode->mpNext);
+			pNode->~node_type();
+			pNode = temp;
+		}
+	}
+
+
+	template <typename T, typename Allocator>
+	void ListBase<T, Allocator>::DestroyValues(true_type)
+	{
+		// empty
+	}
+
+
 	///////////////////////////////////////////////////////////////////////
 	// list
 	///////////////////////////////////////////////////////////////////////
@@ -753,11 +836,11 @@ namespace ministl
 
 	template <typename T, typename Allocator>
 	typename list<T, Allocator>::iterator
-	list<T, Allocator>::insert(const_iterator pos, size_type mSize, const T &value)
+	list<T, Allocator>::insert(const_iterator pos, size_type n, const T &value)
 	{
-		for (; mSize > 0; --mSize)
-			pos = insert(pos, value);
-		return iterator(pos.mpNode);
+		ListNodeBase *pPrev = pos.mpNode->mpPrev;
+		InsertValues(pos.mpNode, n, value);
+		return iterator(pPrev->mpNext);
 	}
 
 
@@ -766,9 +849,9 @@ namespace ministl
 	typename list<T, Allocator>::iterator
 	list<T, Allocator>::insert(const_iterator pos, InputIterator first, InputIterator last)
 	{
-		for (; first != last; ++first)
-			pos = insert(pos, *first);
-		return iterator(pos.mpNode);
+		ListNodeBase *pPrev = pos.mpNode->mpPrev;
+		Insert(pos.mpNode, first, last, is_integral<InputIterator>());
+		return iterator(pPrev->mpNext);
 	}
 
 
@@ -1158,12 +1241,48 @@ namespace ministl
 
 	template <typename T, typename Allocator>
 	void list<T, Allocator>::InsertValues(ListNodeBase *pNode, size_type n, const T& value)
+	{
+		InsertValues(pNode, n, value, typename allocator_traits<Allocator>::has_batch_allocate());
+	}
+
+
+	template <typename T, typename Allocator>
+	void list<T, Allocator>::InsertValues(ListNodeBase *pNode, size_type n, const T& value, false_type)
 	{
 		for (; n > 0; --n)
 			InsertValue(pNode, value);
 	}
 
 
+	// takes all n nodes from the allocator at once, so they lie next to
+	// each other in the order they are linked.
+	template <typename T, typename Allocator>
+	void list<T, Allocator>::InsertValues(ListNodeBase *pNode, size_type n, const T& value, true_type)
+	{
+		if (n == 0)
+			return;
+
+		void *pRun = AllocateNodes(n);
+		try
+		{
+			while (pRun)
+			{
+				node_type *pNewNode = static_cast<node_type*>(pRun);
+				void *pNext = *static_cast<void**>(pRun);
+				new(&pNewNode->mValue)value_type(value);
+				pRun = pNext;
+				pNewNode->insert(pNode);
+				++mSize;
+			}
+		}
+		catch (...)
+		{
+			FreeNodes(pRun);
+			throw;
+		}
+	}
+
+
 	template <typename T, typename Allocator>
 	template <typename Integer>
 	void list<T, Allocator>::Insert(ListNodeBase* pNode, Integer n, Integer value, true_type)
@@ -1175,12 +1294,67 @@ namespace ministl
 	template <typename T, typename Allocator>
 	template <typename InputIterator>
 	void list<T, Allocator>::Insert(ListNodeBase* pNode, InputIterator first, InputIterator last, false_type)
+	{
+		InsertRange(pNode, first, last, typename allocator_traits<Allocator>::has_batch_allocate());
+	}
+
+
+	template <typename T, typename Allocator>
+	template <typename InputIterator>
+	void list<T, Allocator>::InsertRange(ListNodeBase* pNode, InputIterator first, InputIterator last, false_type)
 	{
 		for (; first != last; ++first)
 			InsertValue(pNode, *first);
 	}
 
 
+	template <typename T, typename Allocator>
+	template <typename InputIterator>
+	void list<T, Allocator>::InsertRange(ListNodeBase* pNode, InputIterator first, InputIterator last, true_type)
+	{
+		InsertRange(pNode, first, last, typename iterator_traits<InputIterator>::iterator_category());
+	}
+
+
+	template <typename T, typename Allocator>
+	template <typename InputIterator>
+	void list<T, Allocator>::InsertRange(ListNodeBase* pNode, InputIterator first, InputIterator last, input_iterator_tag)
+	{
+		InsertRange(pNode, first, last, false_type());
+	}
+
+
+	// a forward range can be counted first, and then all its nodes are
+	// taken from the allocator at once.
+	template <typename T, typename Allocator>
+	template <typename ForwardIterator>
+	void list<T, Allocator>::InsertRange(ListNodeBase* pNode, ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+	{
+		size_type n = static_cast<size_type>(ministl::distance(first, last));
+		if (n == 0)
+			return;
+
+		void *pRun = AllocateNodes(n);
+		try
+		{
+			for (; first != last; ++first)
+			{
+				node_type *pNewNode = static_cast<node_type*>(pRun);
+				void *pNext = *static_cast<void**>(pRun);
+				new(&pNewNode->mValue)value_type(*first);
+				pRun = pNext;
+				pNewNode->insert(pNode);
+				++mSize;
+			}
+		}
+		catch (...)
+		{
+			FreeNodes(pRun);
+			throw;
+		}
+	}
+
+
 	template <typename T, typename Allocator>
 	void list<T, Allocator>::Erase(node_type *pNode)
 	{
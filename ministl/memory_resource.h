@@ -0,0 +1,513 @@
+#ifndef MEMORY_RESOURCE_H
+#define MEMORY_RESOURCE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include "arena_alloc.h"
+#include "sub_alloc.h"
+
+namespace ministl
+{
+	/// memory_resource
+	///
+	/// The interface behind polymorphic_allocator. Containers instantiated
+	/// with polymorphic_allocator all have the same type, and the resource
+	/// each one takes its memory from is chosen at run time. A resource is
+	/// not owned by the allocators that point to it and must outlive them.
+	class memory_resource
+	{
+	public:
+		virtual ~memory_resource();
+
+		void *allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+		void  deallocate(void *p, size_t bytes, size_t align = alignof(std::max_align_t));
+		bool  is_equal(const memory_resource &other)const;
+
+	protected:
+		virtual void *do_allocate(size_t bytes, size_t align) = 0;
+		virtual void  do_deallocate(void *p, size_t bytes, size_t align) = 0;
+		virtual bool  do_is_equal(const memory_resource &other)const = 0;
+	};
+
+	bool operator==(const memory_resource &lhs, const memory_resource &rhs);
+	bool operator!=(const memory_resource &lhs, const memory_resource &rhs);
+
+	memory_resource *new_delete_resource();
+	memory_resource *get_default_resource();
+	memory_resource *set_default_resource(memory_resource *r);
+
+
+	/// new_delete_resource
+	///
+	/// The resource returned by new_delete_resource(), and the default
+	/// resource until set_default_resource replaces it. Alignments above
+	/// alignof(max_align_t) are handled by asking operator new for a little
+	/// more, and keeping the pointer it returned right before the block.
+	class __new_delete_resource : public memory_resource
+	{
+	protected:
+		void *do_allocate(size_t bytes, size_t align);
+		void  do_deallocate(void *p, size_t bytes, size_t align);
+		bool  do_is_equal(const memory_resource &other)const;
+	};
+
+
+	/// monotonic_buffer_resource
+	///
+	/// A memory_resource over a monotonic_arena, see arena_alloc.h.
+	/// deallocate does nothing, and release gives back everything allocated
+	/// so far at once. It may start from a buffer owned by the caller.
+	class monotonic_buffer_resource : public memory_resource
+	{
+	public:
+		explicit monotonic_buffer_resource(size_t initial_size = 4096);
+		monotonic_buffer_resource(void *buffer, size_t size);
+
+		void release();
+
+	private:
+		monotonic_buffer_resource(const monotonic_buffer_resource&);
+		monotonic_buffer_resource &operator=(const monotonic_buffer_resource&);
+
+	protected:
+		void *do_allocate(size_t bytes, size_t align);
+		void  do_deallocate(void *p, size_t bytes, size_t align);
+		bool  do_is_equal(const memory_resource &other)const;
+
+	private:
+		monotonic_arena mArena;
+	};
+
+
+	enum
+	{
+		// the least a pool_resource takes from upstream at once.
+		__POOL_CHUNK_BYTES = 16 * 1024
+	};
+
+
+	/// pool_resource
+	///
+	/// A pool of its own, with the size classes of __default_allocator (see
+	/// sub_alloc.h): a free list per class, refilled by carving nodes from
+	/// chunks of at least __POOL_CHUNK_BYTES taken from the upstream
+	/// resource. Each resource only frees its own memory, so containers
+	/// given different pool resources do not share free lists. The pool
+	/// serves alignments up to __MAX_POOL_ALIGN and sizes up to
+	/// __MAX_ALLOCATE_SIZE; anything else goes to the upstream resource.
+	/// release, and the destructor, give every chunk back to the upstream
+	/// resource at once, including those of nodes still in use.
+	///
+	/// synchronized_pool_resource may be used from any number of threads.
+	/// unsynchronized_pool_resource takes no locks at all and must only be
+	/// used from one thread at a time.
+	template <bool threads>
+	class pool_resource : public memory_resource
+	{
+	public:
+		explicit pool_resource(memory_resource *upstream = get_default_resource());
+		~pool_resource();
+
+		void             release();
+		memory_resource *upstream_resource()const;
+
+	private:
+		pool_resource(const pool_resource&);
+		pool_resource &operator=(const pool_resource&);
+
+	protected:
+		void *do_allocate(size_t bytes, size_t align);
+		void  do_deallocate(void *p, size_t bytes, size_t align);
+		bool  do_is_equal(const memory_resource &other)const;
+
+	private:
+		typedef __default_allocator<threads> pool_type;
+
+		struct free_node
+		{
+			free_node *mpNext;
+		};
+
+		struct chunk
+		{
+			chunk  *mpNext;
+			size_t  mSize;
+		};
+
+		static size_t pool_size(size_t bytes, size_t align);
+		void *refill(size_t index);
+
+	private:
+		memory_resource *mpUpstream;
+		free_node       *mpFreeList[__N_FREE_LIST];
+		chunk           *mpChunks;
+		char            *mpCurrent;
+		char            *mpEnd;
+		std::mutex       mLock;    // only taken when threads is true
+	};
+
+	typedef pool_resource<true>  synchronized_pool_resource;
+	typedef pool_resource<false> unsynchronized_pool_resource;
+
+
+	/// polymorphic_allocator
+	///
+	/// An Allocator for list, forward_list, and the adaptors built on them,
+	/// that forwards to a memory_resource. It defaults to
+	/// get_default_resource(). allocate(n) asks for alignof(max_align_t),
+	/// enough for a node of any type, as arena_allocator does; more
+	/// strictly aligned memory is asked for with allocate(n, align).
+	///
+	///     synchronized_pool_resource pool;
+	///     list<int, polymorphic_allocator> l{polymorphic_allocator(&pool)};
+	class polymorphic_allocator
+	{
+	public:
+		polymorphic_allocator();
+		polymorphic_allocator(memory_resource *r);
+
+		void *allocate(size_t n);
+		void *allocate(size_t n, size_t align);
+		void  deallocate(void *p, size_t n);
+		void  deallocate(void *p, size_t n, size_t align);
+
+		memory_resource *resource()const;
+
+	private:
+		memory_resource *mpResource;
+	};
+
+	bool operator==(const polymorphic_allocator &lhs, const polymorphic_allocator &rhs);
+	bool operator!=(const polymorphic_allocator &lhs, const polymorphic_allocator &rhs);
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// memory_resource
+	///////////////////////////////////////////////////////////////////////
+
+	inline memory_resource::~memory_resource()
+	{
+		// empty
+	}
+
+	inline void *memory_resource::allocate(size_t bytes, size_t align)
+	{
+		return do_allocate(bytes, align);
+	}
+
+	inline void memory_resource::deallocate(void *p, size_t bytes, size_t align)
+	{
+		do_deallocate(p, bytes, align);
+	}
+
+	inline bool memory_resource::is_equal(const memory_resource &other)const
+	{
+		return do_is_equal(other);
+	}
+
+	inline bool operator==(const memory_resource &lhs, const memory_resource &rhs)
+	{
+		return &lhs == &rhs || lhs.is_equal(rhs);
+	}
+
+	inline bool operator!=(const memory_resource &lhs, const memory_resource &rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	inline memory_resource *new_delete_resource()
+	{
+		static __new_delete_resource resource;
+		return &resource;
+	}
+
+	inline std::atomic<memory_resource*> &__default_resource()
+	{
+		static std::atomic<memory_resource*> resource(new_delete_resource());
+		return resource;
+	}
+
+	inline memory_resource *get_default_resource()
+	{
+		return __default_resource().load(std::memory_order_acquire);
+	}
+
+	// a null pointer restores new_delete_resource(). Returns the previous
+	// default resource.
+	inline memory_resource *set_default_resource(memory_resource *r)
+	{
+		if (!r)
+			r = new_delete_resource();
+		return __default_resource().exchange(r, std::memory_order_acq_rel);
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// new_delete_resource
+	///////////////////////////////////////////////////////////////////////
+
+	inline void *__new_delete_resource::do_allocate(size_t bytes, size_t align)
+	{
+		if (align <= alignof(std::max_align_t))
+			return ::operator new(bytes);
+
+		char *raw = static_cast<char*>(::operator new(bytes + align + sizeof(void*)));
+		uintptr_t first = reinterpret_cast<uintptr_t>(raw + sizeof(void*));
+		char *result = reinterpret_cast<char*>((first + align - 1) & ~(static_cast<uintptr_t>(align) - 1));
+		reinterpret_cast<char**>(result)[-1] = raw;
+		return result;
+	}
+
+	inline void __new_delete_resource::do_deallocate(void *p, size_t, size_t align)
+	{
+		if (align <= alignof(std::max_align_t))
+			return ::operator delete(p);
+
+		::operator delete(static_cast<char**>(p)[-1]);
+	}
+
+	inline bool __new_delete_resource::do_is_equal(const memory_resource &other)const
+	{
+		return this == &other;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// monotonic_buffer_resource
+	///////////////////////////////////////////////////////////////////////
+
+	inline monotonic_buffer_resource::monotonic_buffer_resource(size_t initial_size)
+		: mArena(initial_size)
+	{
+		// empty
+	}
+
+	inline monotonic_buffer_resource::monotonic_buffer_resource(void *buffer, size_t size)
+		: mArena(buffer, size)
+	{
+		// empty
+	}
+
+	inline void monotonic_buffer_resource::release()
+	{
+		mArena.reset();
+	}
+
+	inline void *monotonic_buffer_resource::do_allocate(size_t bytes, size_t align)
+	{
+		return mArena.allocate(bytes, align);
+	}
+
+	inline void monotonic_buffer_resource::do_deallocate(void*, size_t, size_t)
+	{
+		// empty, memory comes back with release
+	}
+
+	inline bool monotonic_buffer_resource::do_is_equal(const memory_resource &other)const
+	{
+		return this == &other;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// pool_resource
+	///////////////////////////////////////////////////////////////////////
+
+	template <bool threads>
+	inline pool_resource<threads>::pool_resource(memory_resource *upstream)
+		: mpUpstream(upstream),
+		  mpChunks(nullptr),
+		  mpCurrent(nullptr),
+		  mpEnd(nullptr)
+	{
+		for (size_t i = 0; i < __N_FREE_LIST; ++i)
+			mpFreeList[i] = nullptr;
+	}
+
+	template <bool threads>
+	inline pool_resource<threads>::~pool_resource()
+	{
+		release();
+	}
+
+	template <bool threads>
+	void pool_resource<threads>::release()
+	{
+		std::unique_lock<std::mutex> lock(mLock, std::defer_lock);
+		if (threads)
+			lock.lock();
+
+		while (mpChunks)
+		{
+			chunk *pNext = mpChunks->mpNext;
+			mpUpstream->deallocate(mpChunks, mpChunks->mSize, alignof(std::max_align_t));
+			mpChunks = pNext;
+		}
+		for (size_t i = 0; i < __N_FREE_LIST; ++i)
+			mpFreeList[i] = nullptr;
+		mpCurrent = mpEnd = nullptr;
+	}
+
+	template <bool threads>
+	inline memory_resource *pool_resource<threads>::upstream_resource()const
+	{
+		return mpUpstream;
+	}
+
+	// the size the pool rounds a request to as __default_allocator does, or
+	// 0 when the request goes upstream.
+	template <bool threads>
+	inline size_t pool_resource<threads>::pool_size(size_t bytes, size_t align)
+	{
+		if (align < __ALIGN)
+			align = __ALIGN;
+		size_t size = bytes ? (bytes + align - 1) & ~(align - 1) : align;
+		if (align > __MAX_POOL_ALIGN || size > __MAX_ALLOCATE_SIZE)
+			return 0;
+		return size;
+	}
+
+	template <bool threads>
+	void *pool_resource<threads>::do_allocate(size_t bytes, size_t align)
+	{
+		size_t size = pool_size(bytes, align);
+		if (!size)
+			return mpUpstream->allocate(bytes, align);
+
+		size_t i = pool_type::freelist_index(size);
+		std::unique_lock<std::mutex> lock(mLock, std::defer_lock);
+		if (threads)
+			lock.lock();
+
+		free_node *result = mpFreeList[i];
+		if (!result)
+			return refill(i);
+		mpFreeList[i] = result->mpNext;
+		return result;
+	}
+
+	template <bool threads>
+	void pool_resource<threads>::do_deallocate(void *p, size_t bytes, size_t align)
+	{
+		size_t size = pool_size(bytes, align);
+		if (!size)
+			return mpUpstream->deallocate(p, bytes, align);
+
+		size_t i = pool_type::freelist_index(size);
+		std::unique_lock<std::mutex> lock(mLock, std::defer_lock);
+		if (threads)
+			lock.lock();
+
+		free_node *node = static_cast<free_node*>(p);
+		node->mpNext = mpFreeList[i];
+		mpFreeList[i] = node;
+	}
+
+	template <bool threads>
+	inline bool pool_resource<threads>::do_is_equal(const memory_resource &other)const
+	{
+		return this == &other;
+	}
+
+	// carves a batch of nodes of the index-th class, aligned as the class
+	// requires, returns the first and puts the rest in its free list. When
+	// the current chunk is too small, its tail is left unused and a new one
+	// is taken from upstream. The caller holds the lock.
+	template <bool threads>
+	void *pool_resource<threads>::refill(size_t index)
+	{
+		size_t n = pool_type::class_size(index);
+		size_t align = pool_type::class_align(n);
+		size_t n_node = pool_type::initial_refill_count(index);
+		size_t gap = (0 - reinterpret_cast<uintptr_t>(mpCurrent)) & (align - 1);
+
+		if (!mpCurrent || static_cast<size_t>(mpEnd - mpCurrent) < gap + n)
+		{
+			size_t bytes = sizeof(chunk) + align + n * n_node;
+			if (bytes < __POOL_CHUNK_BYTES)
+				bytes = __POOL_CHUNK_BYTES;
+
+			chunk *pChunk = static_cast<chunk*>(mpUpstream->allocate(bytes, alignof(std::max_align_t)));
+			pChunk->mpNext = mpChunks;
+			pChunk->mSize = bytes;
+			mpChunks = pChunk;
+			mpCurrent = reinterpret_cast<char*>(pChunk + 1);
+			mpEnd = reinterpret_cast<char*>(pChunk) + bytes;
+			gap = (0 - reinterpret_cast<uintptr_t>(mpCurrent)) & (align - 1);
+		}
+
+		mpCurrent += gap;
+		size_t n_fit = static_cast<size_t>(mpEnd - mpCurrent) / n;
+		if (n_node > n_fit)
+			n_node = n_fit;
+
+		char *result = mpCurrent;
+		mpCurrent += n * n_node;
+		for (char *p = mpCurrent; p != result + n; )
+		{
+			p -= n;
+			free_node *node = reinterpret_cast<free_node*>(p);
+			node->mpNext = mpFreeList[index];
+			mpFreeList[index] = node;
+		}
+		return result;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// polymorphic_allocator
+	///////////////////////////////////////////////////////////////////////
+
+	inline polymorphic_allocator::polymorphic_allocator()
+		: mpResource(get_default_resource())
+	{
+		// empty
+	}
+
+	inline polymorphic_allocator::polymorphic_allocator(memory_resource *r)
+		: mpResource(r)
+	{
+		// empty
+	}
+
+	inline void *polymorphic_allocator::allocate(size_t n)
+	{
+		return mpResource->allocate(n, alignof(std::max_align_t));
+	}
+
+	inline void *polymorphic_allocator::allocate(size_t n, size_t align)
+	{
+		return mpResource->allocate(n, align);
+	}
+
+	inline void polymorphic_allocator::deallocate(void *p, size_t n)
+	{
+		mpResource->deallocate(p, n, alignof(std::max_align_t));
+	}
+
+	inline void polymorphic_allocator::deallocate(void *p, size_t n, size_t align)
+	{
+		mpResource->deallocate(p, n, align);
+	}
+
+	inline memory_resource *polymorphic_allocator::resource()const
+	{
+		return mpResource;
+	}
+
+	inline bool operator==(const polymorphic_allocator &lhs, const polymorphic_allocator &rhs)
+	{
+		return *lhs.resource() == *rhs.resource();
+	}
+
+	inline bool operator!=(const polymorphic_allocator &lhs, const polymorphic_allocator &rhs)
+	{
+		return !(lhs == rhs);
+	}
+}
+
+#endif
@@ -0,0 +1,308 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <atomic>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "allocator.h"
+#include "atomic_wait.h"
+#include "type_traits.h"
+
+namespace ministl
+{
+	/// mpmc_queue
+	///
+	/// A bounded FIFO any number of threads may push to and pop from at the
+	/// same time, without locks (D. Vyukov's bounded MPMC queue). Every slot
+	/// has a sequence number that says whose turn it is: a slot at position
+	/// pos is free for the producer of pos when its sequence is pos, and
+	/// full for the consumer of pos when it is pos + 1. A producer claims a
+	/// position with a compare and swap on mEnqueuePos, builds the element
+	/// and then publishes it by storing pos + 1; a consumer does the same
+	/// with mDequeuePos and hands the slot to the producer of the next lap
+	/// by storing pos + capacity. Producers and consumers only meet on the
+	/// slots, and the two positions are on cache lines of their own.
+	///
+	/// try_push and try_pop fail at once when the queue is full or empty.
+	/// push and pop spin for a while and then park on a futex until a
+	/// thread on the other side makes progress.
+	///
+	/// Once a slot is claimed its element must be built, or the position
+	/// would never be published, so T has to move without throwing: values
+	/// that cannot be built from the arguments without throwing are built
+	/// before a slot is claimed, and moved into it.
+	template <typename T, typename Allocator = alloc>
+	class mpmc_queue
+	{
+		typedef mpmc_queue<T, Allocator>         this_type;
+
+		static_assert(std::is_nothrow_move_constructible<T>::value && std::is_nothrow_move_assignable<T>::value,
+		              "mpmc_queue needs T to move without throwing");
+
+	public:
+		typedef T                                value_type;
+		typedef size_t                           size_type;
+		typedef Allocator                        allocator_type;
+
+	public:
+		explicit mpmc_queue(size_type capacity, const allocator_type &alloc = Allocator());
+		mpmc_queue(const this_type&) = delete;
+		this_type &operator=(const this_type&) = delete;
+		~mpmc_queue();
+
+		bool      try_push(const T &value);
+		bool      try_push(T &&value);
+		template <typename...Args>
+		bool      try_emplace(Args&&...args);
+		bool      try_pop(T &value);
+
+		void      push(const T &value);
+		void      push(T &&value);
+		void      pop(T &value);
+
+		bool      empty()const;
+		size_type size()const;
+		size_type capacity()const;
+
+		const allocator_type &get_allocator()const;
+
+	protected:
+		struct Cell
+		{
+			std::atomic<size_type>   mSequence;
+			alignas(T) unsigned char mValue[sizeof(T)];
+		};
+
+		template <typename...Args>
+		bool TryEmplace(true_type, Args&&...args);
+		template <typename...Args>
+		bool TryEmplace(false_type, Args&&...args);
+
+	protected:
+		Cell           *mpCells;
+		size_type       mMask;
+		allocator_type  mAllocator;
+
+		alignas(__CACHE_LINE_SIZE) std::atomic<size_type> mEnqueuePos;
+		alignas(__CACHE_LINE_SIZE) std::atomic<size_type> mDequeuePos;
+		alignas(__CACHE_LINE_SIZE) parking_lot mNotFull;
+		alignas(__CACHE_LINE_SIZE) parking_lot mNotEmpty;
+	};
+
+
+	// capacity is rounded up to a power of two, and at least 2.
+	template <typename T, typename Allocator>
+	mpmc_queue<T, Allocator>::mpmc_queue(size_type capacity, const allocator_type &alloc)
+		: mpCells(nullptr),
+		  mMask(0),
+		  mAllocator(alloc),
+		  mEnqueuePos(0),
+		  mDequeuePos(0)
+	{
+		size_type n = 2;
+		while (n < capacity)
+		{
+			if (n > size_type(-1) / 2 / sizeof(Cell))
+				throw std::length_error("mpmc_queue capacity too large");
+			n <<= 1;
+		}
+		mpCells = (Cell*)allocate_memory(mAllocator, n * sizeof(Cell));
+		mMask = n - 1;
+		for (size_type i = 0; i < n; ++i)
+			::new(static_cast<void*>(&mpCells[i].mSequence)) std::atomic<size_type>(i);
+	}
+
+
+	template <typename T, typename Allocator>
+	mpmc_queue<T, Allocator>::~mpmc_queue()
+	{
+		size_type end = mEnqueuePos.load(std::memory_order_relaxed);
+		for (size_type pos = mDequeuePos.load(std::memory_order_relaxed); pos != end; ++pos)
+			reinterpret_cast<T*>(mpCells[pos & mMask].mValue)->~T();
+		MINISTLFree(mAllocator, mpCells, (mMask + 1) * sizeof(Cell));
+	}
+
+
+	template <typename T, typename Allocator>
+	inline bool mpmc_queue<T, Allocator>::try_push(const T &value)
+	{
+		return try_emplace(value);
+	}
+
+
+	template <typename T, typename Allocator>
+	inline bool mpmc_queue<T, Allocator>::try_push(T &&value)
+	{
+		return try_emplace(std::move(value));
+	}
+
+
+	template <typename T, typename Allocator>
+	template <typename...Args>
+	inline bool mpmc_queue<T, Allocator>::try_emplace(Args&&...args)
+	{
+		return TryEmplace(bool_type<std::is_nothrow_constructible<T, Args&&...>::value>(),
+		                  std::forward<Args>(args)...);
+	}
+
+
+	template <typename T, typename Allocator>
+	bool mpmc_queue<T, Allocator>::try_pop(T &value)
+	{
+		Cell *pCell;
+		size_type pos = mDequeuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			pCell = mpCells + (pos & mMask);
+			size_type sequence = pCell->mSequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = ptrdiff_t(sequence) - ptrdiff_t(pos + 1);
+			if (diff == 0)
+			{
+				if (mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = mDequeuePos.load(std::memory_order_relaxed);
+		}
+
+		T *pValue = reinterpret_cast<T*>(pCell->mValue);
+		value = std::move(*pValue);
+		pValue->~T();
+		pCell->mSequence.store(pos + mMask + 1, std::memory_order_release);
+		mNotFull.notify();
+		return true;
+	}
+
+
+	template <typename T, typename Allocator>
+	inline void mpmc_queue<T, Allocator>::push(const T &value)
+	{
+		T temp(value);
+		push(std::move(temp));
+	}
+
+
+	template <typename T, typename Allocator>
+	void mpmc_queue<T, Allocator>::push(T &&value)
+	{
+		for (int i = 0; i < __SPIN_COUNT; ++i)
+		{
+			if (try_push(std::move(value)))
+				return;
+			cpu_relax();
+		}
+		for (;;)
+		{
+			uint32_t epoch = mNotFull.prepare_wait();
+			if (try_push(std::move(value)))
+			{
+				mNotFull.cancel_wait();
+				return;
+			}
+			mNotFull.wait(epoch);
+			mNotFull.cancel_wait();
+		}
+	}
+
+
+	template <typename T, typename Allocator>
+	void mpmc_queue<T, Allocator>::pop(T &value)
+	{
+		for (int i = 0; i < __SPIN_COUNT; ++i)
+		{
+			if (try_pop(value))
+				return;
+			cpu_relax();
+		}
+		for (;;)
+		{
+			uint32_t epoch = mNotEmpty.prepare_wait();
+			if (try_pop(value))
+			{
+				mNotEmpty.cancel_wait();
+				return;
+			}
+			mNotEmpty.wait(epoch);
+			mNotEmpty.cancel_wait();
+		}
+	}
+
+
+	template <typename T, typename Allocator>
+	inline bool mpmc_queue<T, Allocator>::empty()const
+	{
+		return size() == 0;
+	}
+
+
+	// only a snapshot while other threads push or pop.
+	template <typename T, typename Allocator>
+	typename mpmc_queue<T, Allocator>::size_type
+	mpmc_queue<T, Allocator>::size()const
+	{
+		size_type dequeue_pos = mDequeuePos.load(std::memory_order_acquire);
+		size_type enqueue_pos = mEnqueuePos.load(std::memory_order_acquire);
+		return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+	}
+
+
+	template <typename T, typename Allocator>
+	inline typename mpmc_queue<T, Allocator>::size_type
+	mpmc_queue<T, Allocator>::capacity()const
+	{
+		return mMask + 1;
+	}
+
+
+	template <typename T, typename Allocator>
+	inline const typename mpmc_queue<T, Allocator>::allocator_type&
+	mpmc_queue<T, Allocator>::get_allocator()const
+	{
+		return mAllocator;
+	}
+
+
+	template <typename T, typename Allocator>
+	template <typename...Args>
+	bool mpmc_queue<T, Allocator>::TryEmplace(true_type, Args&&...args)
+	{
+		Cell *pCell;
+		size_type pos = mEnqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			pCell = mpCells + (pos & mMask);
+			size_type sequence = pCell->mSequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = ptrdiff_t(sequence) - ptrdiff_t(pos);
+			if (diff == 0)
+			{
+				if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;
+			else
+				pos = mEnqueuePos.load(std::memory_order_relaxed);
+		}
+
+		::new(static_cast<void*>(pCell->mValue)) T(std::forward<Args>(args)...);
+		pCell->mSequence.store(pos + 1, std::memory_order_release);
+		mNotEmpty.notify();
+		return true;
+	}
+
+
+	// builds the value first, so that a throwing constructor leaves no
+	// claimed slot behind.
+	template <typename T, typename Allocator>
+	template <typename...Args>
+	inline bool mpmc_queue<T, Allocator>::TryEmplace(false_type, Args&&...args)
+	{
+		T value(std::forward<Args>(args)...);
+		return TryEmplace(true_type(), std::move(value));
+	}
+}
+
+#endif
@@ -0,0 +1,384 @@
+#ifndef MULTICAST_RING_H
+#define MULTICAST_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <thread>
+#include "allocator.h"
+#include "atomic_wait.h"
+#include "uninitialized.h"
+#include "vector.h"
+
+namespace ministl
+{
+	/// sequence
+	///
+	/// A position in a multicast_ring, -1 before the first event, alone on
+	/// its cache line. The producer publishes with one and every consumer
+	/// reports its progress with one.
+	class alignas(__CACHE_LINE_SIZE) sequence
+	{
+	public:
+		explicit sequence(int64_t value = -1)
+			: mValue(value)
+		{
+			// empty
+		}
+
+		int64_t get()const
+		{
+			return mValue.load(std::memory_order_acquire);
+		}
+
+		void set(int64_t value)
+		{
+			mValue.store(value, std::memory_order_release);
+		}
+
+		sequence(const sequence&) = delete;
+		sequence &operator=(const sequence&) = delete;
+
+	private:
+		std::atomic<int64_t> mValue;
+	};
+
+
+	// the smallest of the n sequences at deps, or value if n is 0.
+	inline int64_t minimum_sequence(const sequence *const *deps, size_t n, int64_t value)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			int64_t dep = deps[i]->get();
+			if (dep < value)
+				value = dep;
+		}
+		return value;
+	}
+
+
+	/// Wait strategies: how a consumer waits for the sequence it needs.
+	/// wait_for returns once the cursor, and every sequence the consumer
+	/// depends on, are at seq or later, with the lowest of them;
+	/// signal_all is called by the producer after each publish.
+
+	/// busy_spin_wait
+	///
+	/// Spins on the sequences: the lowest latency, but a core per consumer.
+	struct busy_spin_wait
+	{
+		int64_t wait_for(int64_t seq, const sequence &cursor, const sequence *const *deps, size_t n)
+		{
+			int64_t available;
+			while ((available = minimum_sequence(deps, n, cursor.get())) < seq)
+				cpu_relax();
+			return available;
+		}
+
+		void signal_all()
+		{
+			// empty
+		}
+	};
+
+
+	/// yielding_wait
+	///
+	/// Spins for a while, then gives the processor away between checks.
+	struct yielding_wait
+	{
+		int64_t wait_for(int64_t seq, const sequence &cursor, const sequence *const *deps, size_t n)
+		{
+			int64_t available;
+			for (int spins = 0; (available = minimum_sequence(deps, n, cursor.get())) < seq; ++spins)
+			{
+				if (spins < __SPIN_COUNT)
+					cpu_relax();
+				else
+					std::this_thread::yield();
+			}
+			return available;
+		}
+
+		void signal_all()
+		{
+			// empty
+		}
+	};
+
+
+	/// blocking_wait
+	///
+	/// Parks on a futex until the producer publishes seq, then yields until
+	/// the stages it depends on have caught up. Uses no processor while idle,
+	/// at the cost of a fence per publish.
+	struct blocking_wait
+	{
+		int64_t wait_for(int64_t seq, const sequence &cursor, const sequence *const *deps, size_t n)
+		{
+			while (cursor.get() < seq)
+			{
+				uint32_t epoch = mPublished.prepare_wait();
+				if (cursor.get() < seq)
+					mPublished.wait(epoch);
+				mPublished.cancel_wait();
+			}
+
+			int64_t available;
+			while ((available = minimum_sequence(deps, n, cursor.get())) < seq)
+				std::this_thread::yield();
+			return available;
+		}
+
+		void signal_all()
+		{
+			mPublished.notify();
+		}
+
+		parking_lot mPublished;
+	};
+
+
+	template <typename T, typename WaitStrategy, typename Allocator>
+	class multicast_ring;
+
+
+	/// sequence_barrier
+	///
+	/// What a consumer waits on: the producer's cursor, and the sequences of
+	/// the consumers of earlier stages it has to stay behind.
+	template <typename T, typename WaitStrategy, typename Allocator>
+	class sequence_barrier
+	{
+		typedef multicast_ring<T, WaitStrategy, Allocator>   ring_type;
+
+	public:
+		sequence_barrier(ring_type &ring, std::initializer_list<const sequence*> deps);
+
+		// blocks until seq can be read, and returns the highest sequence
+		// that can, which may be well past seq.
+		int64_t wait_for(int64_t seq)const;
+
+	protected:
+		ring_type                    *mpRing;
+		vector<const sequence*>       mDeps;
+	};
+
+
+	/// multicast_ring
+	///
+	/// A ring of pre-built events that one producer writes and every
+	/// consumer reads, in order, without copying (the LMAX disruptor). The
+	/// producer claims sequences, fills their events in place and publishes
+	/// them by moving its cursor. Each consumer follows the cursor with its
+	/// own sequence, through a sequence_barrier that can also keep it behind
+	/// other consumers, which makes pipelines such as
+	///
+	///     journal, replicate -> process
+	///
+	/// where process only sees an event once both journal and replicate
+	/// are done with it. The producer never overwrites an event that a
+	/// gating sequence, normally those of the last stage, has not passed.
+	///
+	/// claim and wait_for work in batches: claim(n) reserves n sequences at
+	/// once, and wait_for returns every sequence already published, so a
+	/// consumer that falls behind catches up without waiting per event. A
+	/// consumer is stopped with an event that tells it so.
+	///
+	///     multicast_ring<Event> ring(1024);
+	///     sequence journaled, processed;
+	///     sequence_barrier<Event, blocking_wait, alloc> b1(ring, {});
+	///     sequence_barrier<Event, blocking_wait, alloc> b2(ring, {&journaled});
+	///     ring.add_gating_sequence(processed);
+	///
+	///     int64_t hi = ring.claim(2);     // producer
+	///     ring[hi - 1] = ...; ring[hi] = ...;
+	///     ring.publish(hi);
+	///
+	///     int64_t next = journaled.get() + 1;    // journal
+	///     int64_t available = b1.wait_for(next);
+	///     for (; next <= available; ++next)
+	///         write(ring[next]);
+	///     journaled.set(available);
+	template <typename T, typename WaitStrategy = blocking_wait, typename Allocator = alloc>
+	class multicast_ring
+	{
+		typedef multicast_ring<T, WaitStrategy, Allocator>   this_type;
+
+		friend class sequence_barrier<T, WaitStrategy, Allocator>;
+
+	public:
+		typedef T                                            value_type;
+		typedef T&                                           reference;
+		typedef const T&                                     const_reference;
+		typedef size_t                                       size_type;
+		typedef Allocator                                    allocator_type;
+		typedef sequence_barrier<T, WaitStrategy, Allocator> barrier_type;
+
+	public:
+		explicit multicast_ring(size_type capacity, const allocator_type &alloc = Allocator());
+		multicast_ring(const this_type&) = delete;
+		this_type &operator=(const this_type&) = delete;
+		~multicast_ring();
+
+		reference       operator[](int64_t seq);
+		const_reference operator[](int64_t seq)const;
+
+		size_type capacity()const;
+		int64_t   cursor()const;
+
+		// before the first claim only.
+		void      add_gating_sequence(const sequence &seq);
+
+		// producer
+		int64_t   claim(size_type n = 1);
+		void      publish(int64_t seq);
+
+	protected:
+		T                        *mpEvents;
+		size_type                 mMask;
+		allocator_type            mAllocator;
+		vector<const sequence*>   mGating;
+		int64_t                   mClaimed;         // the producer's last claimed sequence
+		int64_t                   mGatingCache;     // the producer's copy of the slowest gating sequence
+		sequence                  mCursor;
+		WaitStrategy              mWaitStrategy;
+	};
+
+
+	template <typename T, typename WaitStrategy, typename Allocator>
+	sequence_barrier<T, WaitStrategy, Allocator>::sequence_barrier(ring_type &ring,
+	                                                               std::initializer_list<const sequence*> deps)
+		: mpRing(&ring),
+		  mDeps(deps)
+	{
+		// empty
+	}
+
+
+	template <typename T, typename WaitStrategy, typename Allocator>
+	inline int64_t sequence_barrier<T, WaitStrategy, Allocator>::wait_for(int64_t seq)const
+	{
+		return mpRing->mWaitStrategy.wait_for(seq, mpRing->mCursor, mDeps.data(), mDeps.size());
+	}
+
+
+	// capacity is rounded up to a power of two. The events are value
+	// initialized, and live as long as the ring.
+	template <typename T, typename WaitStrategy, typename Allocator>
+	multicast_ring<T, WaitStrategy, Allocator>::multicast_ring(size_type capacity, const allocator_type &alloc)
+		: mpEvents(nullptr),
+		  mMask(0),
+		  mAllocator(alloc),
+		  mGating(),
+		  mClaimed(-1),
+		  mGatingCache(-1),
+		  mCursor(),
+		  mWaitStrategy()
+	{
+		size_type n = 1;
+		while (n < capacity)
+		{
+			if (n > size_type(-1) / 2 / sizeof(T))
+				throw std::length_error("multicast_ring capacity too large");
+			n <<= 1;
+		}
+		mpEvents = (T*)allocate_memory(mAllocator, n * sizeof(T));
+		try
+		{
+			ministl::uninitialized_value_construct_n(mpEvents, n);
+		}
+		catch (...)
+		{
+			MINISTLFree(mAllocator, mpEvents, n * sizeof(T));
+			throw;
+		}
+		mMask = n - 1;
+	}
+
+
+	template <typename T, typename WaitStrategy, typename Allocator>
+	multicast_ring<T, WaitStrategy, Allocator>::~multicast_ring()
+	{
+		ministl::destroy(mpEvents, mpEvents + mMask + 1);
+		MINISTLFree(mAllocator, mpEvents, (mMask + 1) * sizeof(T));
+	}
+
+
+	template <typename T, typename WaitStrategy, typename Allocator>
+	inline typename multicast_ring<T, WaitStrategy, Allocator>::reference
+	multicast_ring<T, WaitStrategy, Allocator>::operator[](int64_t seq)
+	{
+		return mpEvents[size_type(seq) & mMask];
+	}
+
+
+	template <typename T, typename WaitStrategy, typename Allocator>
+	inline typename multicast_ring<T, WaitStrategy, Allocator>::const_reference
+	multicast_ring<T, WaitStrategy, Allocator>::operator[](int64_t seq)const
+	{
+		return mpEvents[size_type(seq) & mMask];
+	}
+
+
+	template <typename T, typename WaitStrategy, typename Allocator>
+	inline typename multicast_ring<T, WaitStrategy, Allocator>::size_type
+	multicast_ring<T, WaitStrategy, Allocator>::capacity()const
+	{
+		return mMask + 1;
+	}
+
+
+	// the last published sequence.
+	template <typename T, typename WaitStrategy, typename Allocator>
+	inline int64_t multicast_ring<T, WaitStrategy, Allocator>::cursor()const
+	{
+		return mCursor.get();
+	}
+
+
+	template <typename T, typename WaitStrategy, typename Allocator>
+	void multicast_ring<T, WaitStrategy, Allocator>::add_gating_sequence(const sequence &seq)
+	{
+		mGating.push_back(&seq);
+	}
+
+
+	// reserves the next n sequences, n at most capacity(), and returns the
+	// last of them. Waits while that would overwrite an event a gating
+	// sequence has not passed yet.
+	template <typename T, typename WaitStrategy, typename Allocator>
+	int64_t multicast_ring<T, WaitStrategy, Allocator>::claim(size_type n)
+	{
+		if (n == 0 || n > capacity())
+			throw std::invalid_argument("multicast_ring::claim(size_type n) n out of range");
+
+		int64_t next = mClaimed + int64_t(n);
+		int64_t wrap_point = next - int64_t(capacity());
+		if (wrap_point > mGatingCache)
+		{
+			int spins = 0;
+			while (wrap_point > (mGatingCache = minimum_sequence(mGating.data(), mGating.size(), mClaimed)))
+			{
+				if (spins++ < __SPIN_COUNT)
+					cpu_relax();
+				else
+					std::this_thread::yield();
+			}
+		}
+		mClaimed = next;
+		return next;
+	}
+
+
+	// makes every claimed sequence up to seq visible to the consumers.
+	template <typename T, typename WaitStrategy, typename Allocator>
+	void multicast_ring<T, WaitStrategy, Allocator>::publish(int64_t seq)
+	{
+		mCursor.set(seq);
+		mWaitStrategy.signal_all();
+	}
+}
+
+#endif
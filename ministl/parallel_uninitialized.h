@@ -0,0 +1,213 @@
+#ifndef PARALLEL_UNINITIALIZED_H
+#define PARALLEL_UNINITIALIZED_H
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include "iterator.h"
+#include "uninitialized.h"
+
+namespace ministl
+{
+	/// parallel_policy
+	///
+	/// Passed as the first argument of uninitialized_fill_n,
+	/// uninitialized_fill and uninitialized_copy, splits a random access
+	/// range into one chunk per thread:
+	///
+	///     T *p = static_cast<T*>(std::malloc(n * sizeof(T)));
+	///     uninitialized_fill_n(par, p, n, T());
+	///
+	/// Every thread gets at least __PARALLEL_CHUNK_BYTES of the destination,
+	/// so small ranges are done on the calling thread alone. Each chunk is
+	/// written, and its pages faulted in, by the thread it is given to; on
+	/// a first touch NUMA policy the memory of a chunk then ends up on that
+	/// thread's node.
+	///
+	/// The strong exception guarantee holds as for the serial versions: if
+	/// an element throws, the chunks that were completed are destroyed, and
+	/// the first exception is rethrown once all threads are done. Other
+	/// iterators fall back to the serial versions.
+	struct parallel_policy
+	{
+		// empty
+	};
+
+	const parallel_policy par = parallel_policy();
+
+	enum
+	{
+		__PARALLEL_CHUNK_BYTES = 1 << 22
+	};
+
+	enum
+	{
+		__MAX_PARALLEL_THREADS = 64
+	};
+
+	// the number of threads to split n objects of object_size bytes over.
+	inline size_t parallel_thread_count(size_t n, size_t object_size)
+	{
+		size_t threads = std::thread::hardware_concurrency();
+		if (threads == 0)
+			threads = 1;
+		if (threads > __MAX_PARALLEL_THREADS)
+			threads = __MAX_PARALLEL_THREADS;
+
+		size_t chunks = n / (__PARALLEL_CHUNK_BYTES / object_size + 1);
+		if (chunks == 0)
+			chunks = 1;
+		return chunks < threads ? chunks : threads;
+	}
+
+	// runs construct(begin, end) over [0, n) cut into the given number of
+	// chunks, the first one on the calling thread. When any chunk throws,
+	// destroy(begin, end) is run for every chunk that did not, and the
+	// first exception is rethrown. A chunk whose thread cannot be started
+	// is run on the calling thread instead.
+	template <typename Construct, typename Destroy>
+	void parallel_chunks(size_t n, size_t chunks, Construct construct, Destroy destroy)
+	{
+		std::thread        workers[__MAX_PARALLEL_THREADS];
+		bool               done[__MAX_PARALLEL_THREADS] = {};
+		std::exception_ptr errors[__MAX_PARALLEL_THREADS];
+
+		auto run = [&](size_t i)
+		{
+			try
+			{
+				construct(n * i / chunks, n * (i + 1) / chunks);
+				done[i] = true;
+			}
+			catch (...)
+			{
+				errors[i] = std::current_exception();
+			}
+		};
+
+		for (size_t i = 1; i < chunks; ++i)
+		{
+			try
+			{
+				workers[i] = std::thread(run, i);
+			}
+			catch (...)
+			{
+				run(i);
+			}
+		}
+		run(0);
+
+		for (size_t i = 1; i < chunks; ++i)
+		{
+			if (workers[i].joinable())
+				workers[i].join();
+		}
+
+		for (size_t i = 0; i < chunks; ++i)
+		{
+			if (errors[i])
+			{
+				for (size_t j = 0; j < chunks; ++j)
+				{
+					if (done[j])
+						destroy(n * j / chunks, n * (j + 1) / chunks);
+				}
+				std::rethrow_exception(errors[i]);
+			}
+		}
+	}
+
+	template <typename ForwardIterator, typename Size, typename T>
+	ForwardIterator parallel_uninitialized_fill_n_impl(ForwardIterator first, Size size, const T &value,
+	                                                   forward_iterator_tag)
+	{
+		return uninitialized_fill_n(first, size, value);
+	}
+
+	template <typename RandomAccessIterator, typename Size, typename T>
+	RandomAccessIterator parallel_uninitialized_fill_n_impl(RandomAccessIterator first, Size size, const T &value,
+	                                                        random_access_iterator_tag)
+	{
+		typedef typename iterator_traits<RandomAccessIterator>::value_type value_type;
+		if (size <= 0)
+			return first;
+
+		size_t n = static_cast<size_t>(size);
+		size_t chunks = parallel_thread_count(n, sizeof(value_type));
+		if (chunks == 1)
+			return uninitialized_fill_n(first, size, value);
+
+		parallel_chunks(n, chunks,
+			[&](size_t begin, size_t end) { uninitialized_fill_n(first + begin, end - begin, value); },
+			[&](size_t begin, size_t end) { destroy(first + begin, first + end); });
+		return first + n;
+	}
+
+	template <typename ForwardIterator, typename Size, typename T>
+	ForwardIterator uninitialized_fill_n(const parallel_policy&, ForwardIterator first, Size size, const T &value)
+	{
+		return parallel_uninitialized_fill_n_impl(first, size, value,
+			typename iterator_traits<ForwardIterator>::iterator_category());
+	}
+
+	template <typename ForwardIterator, typename T>
+	void parallel_uninitialized_fill_impl(ForwardIterator first, ForwardIterator last, const T &value,
+	                                      forward_iterator_tag)
+	{
+		uninitialized_fill(first, last, value);
+	}
+
+	template <typename RandomAccessIterator, typename T>
+	void parallel_uninitialized_fill_impl(RandomAccessIterator first, RandomAccessIterator last, const T &value,
+	                                      random_access_iterator_tag)
+	{
+		parallel_uninitialized_fill_n_impl(first, last - first, value, random_access_iterator_tag());
+	}
+
+	template <typename ForwardIterator, typename T>
+	void uninitialized_fill(const parallel_policy&, ForwardIterator first, ForwardIterator last, const T &value)
+	{
+		parallel_uninitialized_fill_impl(first, last, value,
+			typename iterator_traits<ForwardIterator>::iterator_category());
+	}
+
+	template <typename InputIterator, typename ForwardIterator>
+	ForwardIterator parallel_uninitialized_copy_impl(InputIterator first, InputIterator last,
+	                                                 ForwardIterator d_first,
+	                                                 input_iterator_tag, forward_iterator_tag)
+	{
+		return uninitialized_copy(first, last, d_first);
+	}
+
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2>
+	RandomAccessIterator2 parallel_uninitialized_copy_impl(RandomAccessIterator1 first, RandomAccessIterator1 last,
+	                                                       RandomAccessIterator2 d_first,
+	                                                       random_access_iterator_tag, random_access_iterator_tag)
+	{
+		typedef typename iterator_traits<RandomAccessIterator2>::value_type value_type;
+		if (first == last)
+			return d_first;
+
+		size_t n = static_cast<size_t>(last - first);
+		size_t chunks = parallel_thread_count(n, sizeof(value_type));
+		if (chunks == 1)
+			return uninitialized_copy(first, last, d_first);
+
+		parallel_chunks(n, chunks,
+			[&](size_t begin, size_t end) { uninitialized_copy(first + begin, first + end, d_first + begin); },
+			[&](size_t begin, size_t end) { destroy(d_first + begin, d_first + end); });
+		return d_first + n;
+	}
+
+	template <typename InputIterator, typename ForwardIterator>
+	ForwardIterator uninitialized_copy(const parallel_policy&, InputIterator first, InputIterator last,
+	                                   ForwardIterator d_first)
+	{
+		return parallel_uninitialized_copy_impl(first, last, d_first,
+			typename iterator_traits<InputIterator>::iterator_category(),
+			typename iterator_traits<ForwardIterator>::iterator_category());
+	}
+}
+
+#endif
@@ -2,12 +2,12 @@
 #include <iostream>
 #include <iterator>
 #include <queue>
-#include <vector>
+#include "vector.h"
 
 namespace ministl
 {
 	template <typename T,
-	          typename Container = std::vector<T>,
+	          typename Container = vector<T>,
 	          typename Compare = std::less<typename Container::value_type>>
 	class priority_queue
 	{
@@ -18,9 +18,12 @@ namespace ministl
 		using size_type        = typename Container::size_type;
 		using reference        = typename Container::reference;
 		using const_reference  = typename Container::const_reference;
+		using allocator_type   = typename Container::allocator_type;
 
 		priority_queue(const Compare &comp, const Container &cont);
 		explicit priority_queue(const Compare &comp = Compare(), Container && cont = Container());
+		explicit priority_queue(const allocator_type &alloc);
+		priority_queue(const Compare &comp, const allocator_type &alloc);
 		priority_queue(const priority_queue &other);
 		priority_queue(priority_queue &&other);
 
@@ -35,6 +38,9 @@ namespace ministl
 		void            pop();
 		void            swap(priority_queue &other);
 
+		allocator_type  get_allocator()const;
+		void            set_allocator(const allocator_type &alloc);
+
 	protected:
 		Compare   comp;
 		Container c;
@@ -50,6 +56,16 @@ namespace ministl
 		: comp{comp}, c{std::move(cont)}
 	{}
 
+	template <typename T, typename Container, typename Compare>
+	priority_queue<T, Container, Compare>::priority_queue(const allocator_type &alloc)
+		: comp(), c(alloc)
+	{}
+
+	template <typename T, typename Container, typename Compare>
+	priority_queue<T, Container, Compare>::priority_queue(const Compare &comp, const allocator_type &alloc)
+		: comp(comp), c(alloc)
+	{}
+
 	template <typename T, typename Container, typename Compare>
 	priority_queue<T, Container, Compare>::priority_queue(const priority_queue &other)
 		: comp{other.c}, c{other.c}
@@ -113,6 +129,21 @@ namespace ministl
 		swap(comp, other.comp);
 	}
 
+	template <typename T, typename Container, typename Compare>
+	inline typename priority_queue<T, Container, Compare>::allocator_type
+	priority_queue<T, Container, Compare>::get_allocator()const
+	{
+		return c.get_allocator();
+	}
+
+	// only for containers with a set_allocator.
+	template <typename T, typename Container, typename Compare>
+	inline void
+	priority_queue<T, Container, Compare>::set_allocator(const allocator_type &alloc)
+	{
+		c.set_allocator(alloc);
+	}
+
 }
 
 
@@ -1,9 +1,9 @@
-#include <deque>
 #include <iostream>
+#include "deque.h"
 
 namespace ministl
 {
-	template <typename T, typename Container = std::deque<T>>
+	template <typename T, typename Container = deque<T>>
 	class queue
 	{
 	public:
@@ -12,9 +12,11 @@ namespace ministl
 		using size_type        = typename Container::size_type;
 		using reference        = typename Container::reference;
 		using const_reference  = typename Container::const_reference;
+		using allocator_type   = typename Container::allocator_type;
 
 		explicit queue(Container&& cont = Container());
 		explicit queue(const Container &cont);
+		explicit queue(const allocator_type &alloc);
 		queue(const queue &other);
 		queue(queue &&other);
 
@@ -31,6 +33,9 @@ namespace ministl
 		void                  pop();
 		void                  swap(queue &other);
 
+		allocator_type        get_allocator()const;
+		void                  set_allocator(const allocator_type &alloc);
+
 	protected:
 		Container c;
 	};
@@ -45,6 +50,11 @@ namespace ministl
 		: c(cont)
 	{}
 
+	template <typename T, typename Container>
+	queue<T, Container>::queue(const allocator_type &alloc)
+		: c(alloc)
+	{}
+
 	template <typename T, typename Container>
 	queue<T, Container>::queue(const queue &other)
 		: c(other.c)
@@ -52,7 +62,7 @@ namespace ministl
 
 	template <typename T, typename Container>
 	queue<T, Container>::queue(queue &&other)
-		: c(std::remove(other.c))
+		: c(std::move(other.c))
 	{}
 
 	template <typename T, typename Container>
@@ -125,11 +135,26 @@ namespace ministl
 		using std::swap;
 		swap(c, other.c);
 	}
+
+	template <typename T, typename Container>
+	inline typename queue<T, Container>::allocator_type
+	queue<T, Container>::get_allocator()const
+	{
+		return c.get_allocator();
+	}
+
+	// only for containers with a set_allocator, like list and forward_list.
+	template <typename T, typename Container>
+	inline void
+	queue<T, Container>::set_allocator(const allocator_type &alloc)
+	{
+		c.set_allocator(alloc);
+	}
 }
 
 int main(int argc, char const *argv[])
 {
-	std::deque<int>dq{1, 2, 3};
+	ministl::deque<int>dq{1, 2, 3};
 	ministl::queue<int>q{dq};
 	q.push(3);
 	q.push(4);
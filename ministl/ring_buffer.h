@@ -0,0 +1,542 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+#include "allocator.h"
+#include "type_traits.h"
+#include "uninitialized.h"
+
+namespace ministl
+{
+	/// What push_back and emplace_back do with a full ring_buffer.
+	enum ring_buffer_mode
+	{
+		ring_buffer_fixed,      // throw std::length_error
+		ring_buffer_overwrite,  // overwrite the oldest element
+		ring_buffer_grow        // double the capacity
+	};
+
+	enum
+	{
+		__RING_BUFFER_DEFAULT_CAPACITY = 16
+	};
+
+
+	/// ring_buffer
+	///
+	/// A FIFO over one contiguous array whose capacity is a power of two, so
+	/// that a position is found with a mask rather than a division. The
+	/// front and back are free running counters, the slot of a counter is
+	/// counter & mMask. Nothing is allocated after construction unless Mode
+	/// is ring_buffer_grow and the buffer fills up.
+	///
+	/// It has what ministl::queue asks of its Container:
+	///
+	///     queue<Message, ring_buffer<Message> > q(ring_buffer<Message>(1024));
+	template <typename T, typename Allocator = alloc, ring_buffer_mode Mode = ring_buffer_fixed>
+	class ring_buffer
+	{
+		typedef ring_buffer<T, Allocator, Mode>          this_type;
+
+	public:
+		typedef T                                        value_type;
+		typedef T*                                       pointer;
+		typedef const T*                                 const_pointer;
+		typedef T&                                       reference;
+		typedef const T&                                 const_reference;
+		typedef size_t                                   size_type;
+		typedef ptrdiff_t                                difference_type;
+		typedef Allocator                                allocator_type;
+
+	public:
+		explicit ring_buffer(size_type capacity = __RING_BUFFER_DEFAULT_CAPACITY,
+		                     const allocator_type &alloc = Allocator());
+		ring_buffer(const this_type &other);
+		ring_buffer(this_type &&other);
+		ring_buffer(std::initializer_list<T> ilist, const allocator_type &alloc = Allocator());
+		~ring_buffer();
+
+		this_type &operator=(const this_type &other);
+		this_type &operator=(this_type &&other);
+
+		reference       at(size_type i);
+		const_reference at(size_type i)const;
+		reference       operator[](size_type i);
+		const_reference operator[](size_type i)const;
+
+		reference       front();
+		const_reference front()const;
+		reference       back();
+		const_reference back()const;
+
+		bool      empty()const;
+		bool      full()const;
+		size_type size()const;
+		size_type capacity()const;
+		void      reserve(size_type n);
+
+		void      clear();
+		void      push_back(const T &value);
+		void      push_back(T &&value);
+		template <typename...Args>
+		reference emplace_back(Args&&...args);
+		void      pop_front();
+		void      swap(this_type &other);
+
+		const allocator_type &get_allocator()const;
+		allocator_type       &get_allocator();
+		void                  set_allocator(const allocator_type &alloc);
+
+	protected:
+		static size_type RoundCapacity(size_type n);
+
+		T   *DoAllocate(size_type n);
+		void DoFree(T *p, size_type n);
+		void Reallocate(size_type n);
+		void Relocate(T *pNew, true_type);
+		void Relocate(T *pNew, false_type);
+		template <typename...Args>
+		reference PushFull(Args&&...args);
+
+	protected:
+		T              *mpBuffer;
+		size_type       mMask;
+		size_type       mHead;
+		size_type       mTail;
+		allocator_type  mAllocator;
+	};
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	ring_buffer<T, Allocator, Mode>::ring_buffer(size_type capacity, const allocator_type &alloc)
+		: mpBuffer(nullptr),
+		  mMask(RoundCapacity(capacity) - 1),
+		  mHead(0),
+		  mTail(0),
+		  mAllocator(alloc)
+	{
+		mpBuffer = DoAllocate(mMask + 1);
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	ring_buffer<T, Allocator, Mode>::ring_buffer(const this_type &other)
+		: mpBuffer(nullptr),
+		  mMask(other.mMask),
+		  mHead(0),
+		  mTail(0),
+		  mAllocator(other.mAllocator)
+	{
+		mpBuffer = DoAllocate(mMask + 1);
+		try
+		{
+			for (size_type i = 0; i < other.size(); ++i)
+				emplace_back(other[i]);
+		}
+		catch (...)
+		{
+			clear();
+			DoFree(mpBuffer, mMask + 1);
+			throw;
+		}
+	}
+
+
+	// leaves other empty with a capacity of 0, it allocates a buffer again
+	// on its next push_back or reserve. Copies of it have no buffer either.
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	ring_buffer<T, Allocator, Mode>::ring_buffer(this_type &&other)
+		: mpBuffer(other.mpBuffer),
+		  mMask(other.mMask),
+		  mHead(other.mHead),
+		  mTail(other.mTail),
+		  mAllocator(other.mAllocator)
+	{
+		other.mpBuffer = nullptr;
+		other.mMask = size_type(-1);
+		other.mHead = other.mTail = 0;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	ring_buffer<T, Allocator, Mode>::ring_buffer(std::initializer_list<T> ilist, const allocator_type &alloc)
+		: mpBuffer(nullptr),
+		  mMask(RoundCapacity(ilist.size()) - 1),
+		  mHead(0),
+		  mTail(0),
+		  mAllocator(alloc)
+	{
+		mpBuffer = DoAllocate(mMask + 1);
+		try
+		{
+			for (const T *p = ilist.begin(); p != ilist.end(); ++p)
+				emplace_back(*p);
+		}
+		catch (...)
+		{
+			clear();
+			DoFree(mpBuffer, mMask + 1);
+			throw;
+		}
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	ring_buffer<T, Allocator, Mode>::~ring_buffer()
+	{
+		clear();
+		DoFree(mpBuffer, mMask + 1);
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	typename ring_buffer<T, Allocator, Mode>::this_type&
+	ring_buffer<T, Allocator, Mode>::operator=(const this_type &other)
+	{
+		if (this != &other)
+		{
+			this_type temp(other);
+			swap(temp);
+		}
+		return *this;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	typename ring_buffer<T, Allocator, Mode>::this_type&
+	ring_buffer<T, Allocator, Mode>::operator=(this_type &&other)
+	{
+		if (this != &other)
+		{
+			this_type temp(std::move(other));
+			swap(temp);
+		}
+		return *this;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline typename ring_buffer<T, Allocator, Mode>::reference
+	ring_buffer<T, Allocator, Mode>::at(size_type i)
+	{
+		if (i >= size())
+			throw std::out_of_range("ring_buffer::at(size_type i) out of range");
+		return mpBuffer[(mHead + i) & mMask];
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline typename ring_buffer<T, Allocator, Mode>::const_reference
+	ring_buffer<T, Allocator, Mode>::at(size_type i)const
+	{
+		if (i >= size())
+			throw std::out_of_range("ring_buffer::at(size_type i) out of range");
+		return mpBuffer[(mHead + i) & mMask];
+	}
+
+
+	// i counts from the front.
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline typename ring_buffer<T, Allocator, Mode>::reference
+	ring_buffer<T, Allocator, Mode>::operator[](size_type i)
+	{
+		return mpBuffer[(mHead + i) & mMask];
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline typename ring_buffer<T, Allocator, Mode>::const_reference
+	ring_buffer<T, Allocator, Mode>::operator[](size_type i)const
+	{
+		return mpBuffer[(mHead + i) & mMask];
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline typename ring_buffer<T, Allocator, Mode>::reference
+	ring_buffer<T, Allocator, Mode>::front()
+	{
+		return mpBuffer[mHead & mMask];
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline typename ring_buffer<T, Allocator, Mode>::const_reference
+	ring_buffer<T, Allocator, Mode>::front()const
+	{
+		return mpBuffer[mHead & mMask];
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline typename ring_buffer<T, Allocator, Mode>::reference
+	ring_buffer<T, Allocator, Mode>::back()
+	{
+		return mpBuffer[(mTail - 1) & mMask];
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline typename ring_buffer<T, Allocator, Mode>::const_reference
+	ring_buffer<T, Allocator, Mode>::back()const
+	{
+		return mpBuffer[(mTail - 1) & mMask];
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline bool ring_buffer<T, Allocator, Mode>::empty()const
+	{
+		return mHead == mTail;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline bool ring_buffer<T, Allocator, Mode>::full()const
+	{
+		return mTail - mHead == mMask + 1;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline typename ring_buffer<T, Allocator, Mode>::size_type
+	ring_buffer<T, Allocator, Mode>::size()const
+	{
+		return mTail - mHead;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline typename ring_buffer<T, Allocator, Mode>::size_type
+	ring_buffer<T, Allocator, Mode>::capacity()const
+	{
+		return mMask + 1;
+	}
+
+
+	// also allowed for the fixed and overwrite modes, it is only push_back
+	// that never grows them.
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	void ring_buffer<T, Allocator, Mode>::reserve(size_type n)
+	{
+		if (n > capacity())
+			Reallocate(RoundCapacity(n));
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	void ring_buffer<T, Allocator, Mode>::clear()
+	{
+		while (!empty())
+			pop_front();
+		mHead = mTail = 0;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline void ring_buffer<T, Allocator, Mode>::push_back(const T &value)
+	{
+		emplace_back(value);
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline void ring_buffer<T, Allocator, Mode>::push_back(T &&value)
+	{
+		emplace_back(std::move(value));
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	template <typename...Args>
+	inline typename ring_buffer<T, Allocator, Mode>::reference
+	ring_buffer<T, Allocator, Mode>::emplace_back(Args&&...args)
+	{
+		if (full())
+			return PushFull(std::forward<Args>(args)...);
+
+		T *pSlot = mpBuffer + (mTail & mMask);
+		::new(static_cast<void*>(pSlot)) value_type(std::forward<Args>(args)...);
+		++mTail;
+		return *pSlot;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline void ring_buffer<T, Allocator, Mode>::pop_front()
+	{
+		mpBuffer[mHead & mMask].~value_type();
+		++mHead;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	void ring_buffer<T, Allocator, Mode>::swap(this_type &other)
+	{
+		std::swap(mpBuffer, other.mpBuffer);
+		std::swap(mMask, other.mMask);
+		std::swap(mHead, other.mHead);
+		std::swap(mTail, other.mTail);
+		std::swap(mAllocator, other.mAllocator);
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline const typename ring_buffer<T, Allocator, Mode>::allocator_type&
+	ring_buffer<T, Allocator, Mode>::get_allocator()const
+	{
+		return mAllocator;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline typename ring_buffer<T, Allocator, Mode>::allocator_type&
+	ring_buffer<T, Allocator, Mode>::get_allocator()
+	{
+		return mAllocator;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline void ring_buffer<T, Allocator, Mode>::set_allocator(const allocator_type &alloc)
+	{
+		mAllocator = alloc;
+	}
+
+
+	// the smallest power of two that is at least n, and at least 1.
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	typename ring_buffer<T, Allocator, Mode>::size_type
+	ring_buffer<T, Allocator, Mode>::RoundCapacity(size_type n)
+	{
+		size_type capacity = 1;
+		while (capacity < n)
+		{
+			if (capacity > size_type(-1) / 2)
+				throw std::length_error("ring_buffer capacity too large");
+			capacity <<= 1;
+		}
+		return capacity;
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline T *ring_buffer<T, Allocator, Mode>::DoAllocate(size_type n)
+	{
+		if (n == 0)
+			return nullptr;
+		if (n > size_type(-1) / sizeof(T))
+			throw std::length_error("ring_buffer capacity too large");
+		return (T*)allocate_memory(mAllocator, n * sizeof(T));
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline void ring_buffer<T, Allocator, Mode>::DoFree(T *p, size_type n)
+	{
+		if (p)
+			MINISTLFree(mAllocator, p, n * sizeof(T));
+	}
+
+
+	// moves the elements to a new buffer of n, a power of two, where they
+	// start at slot 0.
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	void ring_buffer<T, Allocator, Mode>::Reallocate(size_type n)
+	{
+		T *pNew = DoAllocate(n);
+		try
+		{
+			Relocate(pNew, is_trivially_relocatable<T>());
+		}
+		catch (...)
+		{
+			DoFree(pNew, n);
+			throw;
+		}
+		DoFree(mpBuffer, mMask + 1);
+		mTail -= mHead;
+		mHead = 0;
+		mpBuffer = pNew;
+		mMask = n - 1;
+	}
+
+
+	// copies the at most two contiguous runs of elements.
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	void ring_buffer<T, Allocator, Mode>::Relocate(T *pNew, true_type)
+	{
+		size_type head = mHead & mMask;
+		size_type n = size();
+		size_type first_run = n < capacity() - head ? n : capacity() - head;
+		ministl::uninitialized_relocate(mpBuffer + head, mpBuffer + head + first_run, pNew);
+		ministl::uninitialized_relocate(mpBuffer, mpBuffer + (n - first_run), pNew + first_run);
+	}
+
+
+	// the old elements are only destroyed once all of them are moved.
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	void ring_buffer<T, Allocator, Mode>::Relocate(T *pNew, false_type)
+	{
+		size_type i = 0;
+		try
+		{
+			for (; i < size(); ++i)
+				::new(static_cast<void*>(pNew + i)) value_type(std::move((*this)[i]));
+		}
+		catch (...)
+		{
+			ministl::destroy(pNew, pNew + i);
+			throw;
+		}
+		for (i = 0; i < size(); ++i)
+			(*this)[i].~value_type();
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	template <typename...Args>
+	typename ring_buffer<T, Allocator, Mode>::reference
+	ring_buffer<T, Allocator, Mode>::PushFull(Args&&...args)
+	{
+		if (capacity() == 0)
+		{
+			// moved from, or a copy of one, whatever the mode: there is no
+			// element args could refer to.
+			Reallocate(1);
+			return emplace_back(std::forward<Args>(args)...);
+		}
+		else if (Mode == ring_buffer_grow)
+		{
+			// the value is built first, args may refer to an element.
+			value_type value(std::forward<Args>(args)...);
+			Reallocate(capacity() * 2);
+			T *pSlot = mpBuffer + (mTail & mMask);
+			::new(static_cast<void*>(pSlot)) value_type(std::move(value));
+			++mTail;
+			return *pSlot;
+		}
+		else if (Mode == ring_buffer_overwrite)
+		{
+			// the slot of the back to be is the one of the front.
+			T *pSlot = mpBuffer + (mTail & mMask);
+			*pSlot = value_type(std::forward<Args>(args)...);
+			++mHead;
+			++mTail;
+			return *pSlot;
+		}
+		else
+			throw std::length_error("ring_buffer is full");
+	}
+
+
+	template <typename T, typename Allocator, ring_buffer_mode Mode>
+	inline void swap(ring_buffer<T, Allocator, Mode> &lhs, ring_buffer<T, Allocator, Mode> &rhs)
+	{
+		lhs.swap(rhs);
+	}
+}
+
+#endif
@@ -1,11 +1,19 @@
 #include <functional>
 #include <iostream>
+#include "type_traits.h"
 
 namespace ministl
 {
 	template <typename T>
 	class shared_ptr;
 
+	// a shared_ptr is two pointers, and nothing points back at it.
+	template <typename T>
+	struct is_trivially_relocatable<shared_ptr<T>>: true_type
+	{
+
+	};
+
 	template <typename T, typename U>
 	bool operator==(const shared_ptr<T> &lhs, const shared_ptr<U> &rhs)
 	{
@@ -0,0 +1,750 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+#include "allocator.h"
+#include "iterator.h"
+#include "type_traits.h"
+#include "uninitialized.h"
+
+namespace ministl
+{
+	/// small_vector
+	///
+	/// A vector that keeps up to N elements inside itself, and only takes
+	/// memory from Allocator once it holds more. Collections that are
+	/// nearly always small then never allocate at all. Once spilled, it
+	/// stays on the heap until shrink_to_fit brings it back.
+	///
+	/// The elements are relocated between the inline buffer and the heap
+	/// with uninitialized_relocate, i.e. one memcpy for trivially
+	/// relocatable types. A small_vector itself is not trivially
+	/// relocatable, it points into itself while inline.
+	///
+	/// It has what ministl::stack asks of its Container:
+	///
+	///     stack<int, small_vector<int, 8> > s;
+	template <typename T, size_t N, typename Allocator = alloc>
+	class small_vector
+	{
+		typedef small_vector<T, N, Allocator>             this_type;
+
+	public:
+		typedef T                                         value_type;
+		typedef T*                                        pointer;
+		typedef const T*                                  const_pointer;
+		typedef T&                                        reference;
+		typedef const T&                                  const_reference;
+		typedef T*                                        iterator;
+		typedef const T*                                  const_iterator;
+		typedef ministl::reverse_iterator<iterator>       reverse_iterator;
+		typedef ministl::reverse_iterator<const_iterator> const_reverse_iterator;
+		typedef size_t                                    size_type;
+		typedef ptrdiff_t                                 difference_type;
+		typedef Allocator                                 allocator_type;
+
+		enum
+		{
+			inline_capacity = N
+		};
+
+	public:
+		small_vector();
+		small_vector(const allocator_type &alloc);
+		explicit small_vector(size_type n, const allocator_type &alloc = Allocator());
+		small_vector(size_type n, const value_type &value, const allocator_type &alloc = Allocator());
+		small_vector(const this_type &other);
+		small_vector(this_type &&other);
+		small_vector(std::initializer_list<T> ilist, const allocator_type &alloc = Allocator());
+		~small_vector();
+
+		this_type &operator=(const this_type &other);
+		this_type &operator=(this_type &&other);
+
+		reference       at(size_type i);
+		const_reference at(size_type i)const;
+		reference       operator[](size_type i);
+		const_reference operator[](size_type i)const;
+
+		reference       front();
+		const_reference front()const;
+		reference       back();
+		const_reference back()const;
+
+		T*       data();
+		const T* data()const;
+
+		iterator               begin();
+		const_iterator         begin()const;
+		iterator               end();
+		const_iterator         end()const;
+		reverse_iterator       rbegin();
+		const_reverse_iterator rbegin()const;
+		reverse_iterator       rend();
+		const_reverse_iterator rend()const;
+
+		bool      empty()const;
+		size_type size()const;
+		size_type capacity()const;
+		bool      is_inline()const;
+		void      reserve(size_type n);
+		void      shrink_to_fit();
+
+		void      clear();
+		void      push_back(const T &value);
+		void      push_back(T &&value);
+		template <typename...Args>
+		reference emplace_back(Args&&...args);
+		void      pop_back();
+		iterator  erase(const_iterator pos);
+		iterator  erase(const_iterator first, const_iterator last);
+		void      resize(size_type n);
+		void      resize(size_type n, const T &value);
+		void      swap(this_type &other);
+
+		const allocator_type &get_allocator()const;
+		allocator_type       &get_allocator();
+		void                  set_allocator(const allocator_type &alloc);
+
+	protected:
+		T   *Buffer();
+		void Reallocate(size_type n);
+		void FreeHeap();
+		void SwapInline(this_type &other);
+		void SwapHeap(this_type &other);
+
+	protected:
+		T              *mpBegin;
+		T              *mpEnd;
+		T              *mpCapacity;
+		allocator_type  mAllocator;
+		alignas(T) unsigned char mBuffer[sizeof(T) * (N ? N : 1)];
+	};
+
+
+	template <typename T, size_t N, typename Allocator>
+	small_vector<T, N, Allocator>::small_vector()
+		: mpBegin(Buffer()),
+		  mpEnd(Buffer()),
+		  mpCapacity(Buffer() + N),
+		  mAllocator(Allocator())
+	{
+		// empty
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	small_vector<T, N, Allocator>::small_vector(const allocator_type &alloc)
+		: mpBegin(Buffer()),
+		  mpEnd(Buffer()),
+		  mpCapacity(Buffer() + N),
+		  mAllocator(alloc)
+	{
+		// empty
+	}
+
+
+	// no destructor runs when an element throws here, so the constructors
+	// that fill in elements give the heap storage back themselves.
+	template <typename T, size_t N, typename Allocator>
+	small_vector<T, N, Allocator>::small_vector(size_type n, const allocator_type &alloc)
+		: mpBegin(Buffer()),
+		  mpEnd(Buffer()),
+		  mpCapacity(Buffer() + N),
+		  mAllocator(alloc)
+	{
+		try
+		{
+			resize(n);
+		}
+		catch (...)
+		{
+			FreeHeap();
+			throw;
+		}
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	small_vector<T, N, Allocator>::small_vector(size_type n, const value_type &value, const allocator_type &alloc)
+		: mpBegin(Buffer()),
+		  mpEnd(Buffer()),
+		  mpCapacity(Buffer() + N),
+		  mAllocator(alloc)
+	{
+		try
+		{
+			resize(n, value);
+		}
+		catch (...)
+		{
+			FreeHeap();
+			throw;
+		}
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	small_vector<T, N, Allocator>::small_vector(const this_type &other)
+		: mpBegin(Buffer()),
+		  mpEnd(Buffer()),
+		  mpCapacity(Buffer() + N),
+		  mAllocator(other.mAllocator)
+	{
+		try
+		{
+			reserve(other.size());
+			mpEnd = ministl::uninitialized_copy(other.mpBegin, other.mpEnd, mpBegin);
+		}
+		catch (...)
+		{
+			FreeHeap();
+			throw;
+		}
+	}
+
+
+	// takes the heap storage of other when it has spilled, and moves its
+	// elements otherwise.
+	template <typename T, size_t N, typename Allocator>
+	small_vector<T, N, Allocator>::small_vector(this_type &&other)
+		: mpBegin(Buffer()),
+		  mpEnd(Buffer()),
+		  mpCapacity(Buffer() + N),
+		  mAllocator(other.mAllocator)
+	{
+		if (other.is_inline())
+		{
+			mpEnd = ministl::uninitialized_move(other.mpBegin, other.mpEnd, mpBegin);
+			other.clear();
+		}
+		else
+		{
+			mpBegin = other.mpBegin;
+			mpEnd = other.mpEnd;
+			mpCapacity = other.mpCapacity;
+			other.mpBegin = other.mpEnd = other.Buffer();
+			other.mpCapacity = other.Buffer() + N;
+		}
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	small_vector<T, N, Allocator>::small_vector(std::initializer_list<T> ilist, const allocator_type &alloc)
+		: mpBegin(Buffer()),
+		  mpEnd(Buffer()),
+		  mpCapacity(Buffer() + N),
+		  mAllocator(alloc)
+	{
+		try
+		{
+			reserve(ilist.size());
+			mpEnd = ministl::uninitialized_copy(ilist.begin(), ilist.end(), mpBegin);
+		}
+		catch (...)
+		{
+			FreeHeap();
+			throw;
+		}
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	small_vector<T, N, Allocator>::~small_vector()
+	{
+		clear();
+		FreeHeap();
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	typename small_vector<T, N, Allocator>::this_type&
+	small_vector<T, N, Allocator>::operator=(const this_type &other)
+	{
+		if (this != &other)
+		{
+			clear();
+			reserve(other.size());
+			mpEnd = ministl::uninitialized_copy(other.mpBegin, other.mpEnd, mpBegin);
+		}
+		return *this;
+	}
+
+
+	// takes the allocator of other along with its elements, as the move
+	// constructor does, whether other has spilled or not.
+	template <typename T, size_t N, typename Allocator>
+	typename small_vector<T, N, Allocator>::this_type&
+	small_vector<T, N, Allocator>::operator=(this_type &&other)
+	{
+		if (this != &other)
+		{
+			clear();
+			FreeHeap();
+			mpBegin = mpEnd = Buffer();
+			mpCapacity = Buffer() + N;
+			mAllocator = other.mAllocator;
+			if (other.is_inline())
+			{
+				mpEnd = ministl::uninitialized_move(other.mpBegin, other.mpEnd, mpBegin);
+				other.clear();
+			}
+			else
+			{
+				mpBegin = other.mpBegin;
+				mpEnd = other.mpEnd;
+				mpCapacity = other.mpCapacity;
+				other.mpBegin = other.mpEnd = other.Buffer();
+				other.mpCapacity = other.Buffer() + N;
+			}
+		}
+		return *this;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::reference
+	small_vector<T, N, Allocator>::at(size_type i)
+	{
+		if (i >= size())
+			throw std::out_of_range("small_vector::at(size_type i) out of range");
+		return mpBegin[i];
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::const_reference
+	small_vector<T, N, Allocator>::at(size_type i)const
+	{
+		if (i >= size())
+			throw std::out_of_range("small_vector::at(size_type i) out of range");
+		return mpBegin[i];
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::reference
+	small_vector<T, N, Allocator>::operator[](size_type i)
+	{
+		return mpBegin[i];
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::const_reference
+	small_vector<T, N, Allocator>::operator[](size_type i)const
+	{
+		return mpBegin[i];
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::reference
+	small_vector<T, N, Allocator>::front()
+	{
+		return *mpBegin;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::const_reference
+	small_vector<T, N, Allocator>::front()const
+	{
+		return *mpBegin;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::reference
+	small_vector<T, N, Allocator>::back()
+	{
+		return mpEnd[-1];
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::const_reference
+	small_vector<T, N, Allocator>::back()const
+	{
+		return mpEnd[-1];
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline T *small_vector<T, N, Allocator>::data()
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline const T *small_vector<T, N, Allocator>::data()const
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::iterator
+	small_vector<T, N, Allocator>::begin()
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::const_iterator
+	small_vector<T, N, Allocator>::begin()const
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::iterator
+	small_vector<T, N, Allocator>::end()
+	{
+		return mpEnd;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::const_iterator
+	small_vector<T, N, Allocator>::end()const
+	{
+		return mpEnd;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::reverse_iterator
+	small_vector<T, N, Allocator>::rbegin()
+	{
+		return reverse_iterator(mpEnd);
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::const_reverse_iterator
+	small_vector<T, N, Allocator>::rbegin()const
+	{
+		return const_reverse_iterator(mpEnd);
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::reverse_iterator
+	small_vector<T, N, Allocator>::rend()
+	{
+		return reverse_iterator(mpBegin);
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::const_reverse_iterator
+	small_vector<T, N, Allocator>::rend()const
+	{
+		return const_reverse_iterator(mpBegin);
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline bool small_vector<T, N, Allocator>::empty()const
+	{
+		return mpBegin == mpEnd;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::size_type
+	small_vector<T, N, Allocator>::size()const
+	{
+		return mpEnd - mpBegin;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::size_type
+	small_vector<T, N, Allocator>::capacity()const
+	{
+		return mpCapacity - mpBegin;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline bool small_vector<T, N, Allocator>::is_inline()const
+	{
+		return mpBegin == reinterpret_cast<const T*>(mBuffer);
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	void small_vector<T, N, Allocator>::reserve(size_type n)
+	{
+		if (n > capacity())
+			Reallocate(n);
+	}
+
+
+	// moves a spilled small_vector back inline if it fits there again.
+	template <typename T, size_t N, typename Allocator>
+	void small_vector<T, N, Allocator>::shrink_to_fit()
+	{
+		if (!is_inline() && mpCapacity != mpEnd)
+			Reallocate(size());
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	void small_vector<T, N, Allocator>::clear()
+	{
+		ministl::destroy(mpBegin, mpEnd);
+		mpEnd = mpBegin;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline void small_vector<T, N, Allocator>::push_back(const T &value)
+	{
+		emplace_back(value);
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline void small_vector<T, N, Allocator>::push_back(T &&value)
+	{
+		emplace_back(std::move(value));
+	}
+
+
+	// on a full small_vector the element is constructed before it grows, so
+	// args may refer to one of its elements.
+	template <typename T, size_t N, typename Allocator>
+	template <typename...Args>
+	inline typename small_vector<T, N, Allocator>::reference
+	small_vector<T, N, Allocator>::emplace_back(Args&&...args)
+	{
+		if (mpEnd == mpCapacity)
+		{
+			value_type temp(std::forward<Args>(args)...);
+			Reallocate(2 * size() + 1);
+			::new(static_cast<void*>(mpEnd)) value_type(std::move(temp));
+		}
+		else
+			::new(static_cast<void*>(mpEnd)) value_type(std::forward<Args>(args)...);
+		return *mpEnd++;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline void small_vector<T, N, Allocator>::pop_back()
+	{
+		--mpEnd;
+		mpEnd->~value_type();
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	typename small_vector<T, N, Allocator>::iterator
+	small_vector<T, N, Allocator>::erase(const_iterator pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	typename small_vector<T, N, Allocator>::iterator
+	small_vector<T, N, Allocator>::erase(const_iterator first, const_iterator last)
+	{
+		iterator it = mpBegin + (first - mpBegin);
+		if (first != last)
+		{
+			iterator pNewEnd = std::move(mpBegin + (last - mpBegin), mpEnd, it);
+			ministl::destroy(pNewEnd, mpEnd);
+			mpEnd = pNewEnd;
+		}
+		return it;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	void small_vector<T, N, Allocator>::resize(size_type n)
+	{
+		if (n > size())
+		{
+			reserve(n);
+			ministl::uninitialized_value_construct(mpEnd, mpBegin + n);
+			mpEnd = mpBegin + n;
+		}
+		else
+			erase(mpBegin + n, mpEnd);
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	void small_vector<T, N, Allocator>::resize(size_type n, const T &value)
+	{
+		if (n > size())
+		{
+			value_type copy(value);
+			reserve(n);
+			mpEnd = ministl::uninitialized_fill_n(mpEnd, n - size(), copy);
+		}
+		else
+			erase(mpBegin + n, mpEnd);
+	}
+
+
+	// swaps the allocators too. Only the elements that are inline are
+	// moved, heap storage changes hands.
+	template <typename T, size_t N, typename Allocator>
+	void small_vector<T, N, Allocator>::swap(this_type &other)
+	{
+		if (is_inline() && other.is_inline())
+			SwapInline(other);
+		else if (is_inline())
+			other.SwapHeap(*this);
+		else
+			SwapHeap(other);
+		std::swap(mAllocator, other.mAllocator);
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline const typename small_vector<T, N, Allocator>::allocator_type&
+	small_vector<T, N, Allocator>::get_allocator()const
+	{
+		return mAllocator;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline typename small_vector<T, N, Allocator>::allocator_type&
+	small_vector<T, N, Allocator>::get_allocator()
+	{
+		return mAllocator;
+	}
+
+
+	// must come before anything has spilled to the heap.
+	template <typename T, size_t N, typename Allocator>
+	inline void small_vector<T, N, Allocator>::set_allocator(const allocator_type &alloc)
+	{
+		mAllocator = alloc;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline T *small_vector<T, N, Allocator>::Buffer()
+	{
+		return reinterpret_cast<T*>(mBuffer);
+	}
+
+
+	// moves the elements to storage for n >= size() elements: the inline
+	// buffer when n <= N, the heap otherwise.
+	template <typename T, size_t N, typename Allocator>
+	void small_vector<T, N, Allocator>::Reallocate(size_type n)
+	{
+		T *pNew;
+		if (n <= N)
+		{
+			if (is_inline())
+				return;
+			pNew = Buffer();
+			n = N;
+		}
+		else
+			pNew = (T*)allocate_memory(mAllocator, n * sizeof(T));
+
+		size_type count = size();
+		try
+		{
+			ministl::uninitialized_relocate(mpBegin, mpEnd, pNew);
+		}
+		catch (...)
+		{
+			if (pNew != Buffer())
+				MINISTLFree(mAllocator, pNew, n * sizeof(T));
+			throw;
+		}
+		FreeHeap();
+		mpBegin = pNew;
+		mpEnd = pNew + count;
+		mpCapacity = pNew + n;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	inline void small_vector<T, N, Allocator>::FreeHeap()
+	{
+		if (!is_inline())
+			MINISTLFree(mAllocator, mpBegin, capacity() * sizeof(T));
+	}
+
+
+	// both inline: swaps the elements they have in common, and moves the
+	// rest of the longer one over.
+	template <typename T, size_t N, typename Allocator>
+	void small_vector<T, N, Allocator>::SwapInline(this_type &other)
+	{
+		size_type n = size() < other.size() ? size() : other.size();
+		std::swap_ranges(mpBegin, mpBegin + n, other.mpBegin);
+
+		this_type &longer = size() > n ? *this : other;
+		this_type &shorter = size() > n ? other : *this;
+		shorter.mpEnd = ministl::uninitialized_move(longer.mpBegin + n, longer.mpEnd, shorter.mpEnd);
+		ministl::destroy(longer.mpBegin + n, longer.mpEnd);
+		longer.mpEnd = longer.mpBegin + n;
+	}
+
+
+	// this one has spilled: its heap storage goes to other, and the
+	// elements of other, if inline, move into this one's buffer.
+	template <typename T, size_t N, typename Allocator>
+	void small_vector<T, N, Allocator>::SwapHeap(this_type &other)
+	{
+		if (!other.is_inline())
+		{
+			std::swap(mpBegin, other.mpBegin);
+			std::swap(mpEnd, other.mpEnd);
+			std::swap(mpCapacity, other.mpCapacity);
+			return;
+		}
+
+		T *pEnd = ministl::uninitialized_move(other.mpBegin, other.mpEnd, Buffer());
+		other.clear();
+		other.mpBegin = mpBegin;
+		other.mpEnd = mpEnd;
+		other.mpCapacity = mpCapacity;
+		mpBegin = Buffer();
+		mpEnd = pEnd;
+		mpCapacity = Buffer() + N;
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	bool operator==(const small_vector<T, N, Allocator> &lhs, const small_vector<T, N, Allocator> &rhs)
+	{
+		return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	bool operator!=(const small_vector<T, N, Allocator> &lhs, const small_vector<T, N, Allocator> &rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+
+	template <typename T, size_t N, typename Allocator>
+	void swap(small_vector<T, N, Allocator> &lhs, small_vector<T, N, Allocator> &rhs)
+	{
+		lhs.swap(rhs);
+	}
+}
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+#include "allocator.h"
+#include "atomic_wait.h"
+
+namespace ministl
+{
+	/// spsc_queue
+	///
+	/// A bounded FIFO for exactly one producer thread and one consumer
+	/// thread, without locks: every operation finishes in a bounded number
+	/// of steps whatever the other thread does.
+	///
+	/// The slots are an array whose capacity is a power of two. The producer
+	/// owns mTail and the consumer mHead, each on its own cache line so that
+	/// they do not false share. Each side also keeps a copy of the other's
+	/// index, on its own line, and only reads the shared index again when
+	/// that copy leaves too little room (or too few elements) for the call.
+	/// Until then a push or pop touches no cache line the other thread
+	/// writes, and push_n and pop_n publish a whole batch with one store.
+	///
+	/// try_push, try_emplace and push_n may only be called by the producer,
+	/// front, pop, try_pop and pop_n only by the consumer. size and empty
+	/// may be called by either, they are exact for the consumer.
+	template <typename T, typename Allocator = alloc>
+	class spsc_queue
+	{
+		typedef spsc_queue<T, Allocator>         this_type;
+
+	public:
+		typedef T                                value_type;
+		typedef T&                               reference;
+		typedef const T&                         const_reference;
+		typedef size_t                           size_type;
+		typedef Allocator                        allocator_type;
+
+	public:
+		explicit spsc_queue(size_type capacity, const allocator_type &alloc = Allocator());
+		spsc_queue(const this_type&) = delete;
+		this_type &operator=(const this_type&) = delete;
+		~spsc_queue();
+
+		// producer
+		bool      try_push(const T &value);
+		bool      try_push(T &&value);
+		template <typename...Args>
+		bool      try_emplace(Args&&...args);
+		template <typename InputIterator>
+		size_type push_n(InputIterator first, size_type n);
+
+		// consumer
+		reference front();
+		void      pop();
+		bool      try_pop(T &value);
+		template <typename OutputIterator>
+		size_type pop_n(OutputIterator d_first, size_type n);
+
+		bool      empty()const;
+		size_type size()const;
+		size_type capacity()const;
+
+		const allocator_type &get_allocator()const;
+
+	protected:
+		size_type FreeSlots(size_type wanted);
+		size_type UsedSlots(size_type wanted);
+
+	protected:
+		T              *mpBuffer;
+		size_type       mMask;
+		allocator_type  mAllocator;
+
+		alignas(__CACHE_LINE_SIZE) std::atomic<size_type> mTail;
+		alignas(__CACHE_LINE_SIZE) size_type mHeadCache;    // the producer's copy of mHead
+		alignas(__CACHE_LINE_SIZE) std::atomic<size_type> mHead;
+		alignas(__CACHE_LINE_SIZE) size_type mTailCache;    // the consumer's copy of mTail
+	};
+
+
+	template <typename T, typename Allocator>
+	spsc_queue<T, Allocator>::spsc_queue(size_type capacity, const allocator_type &alloc)
+		: mpBuffer(nullptr),
+		  mMask(0),
+		  mAllocator(alloc),
+		  mTail(0),
+		  mHeadCache(0),
+		  mHead(0),
+		  mTailCache(0)
+	{
+		size_type n = 1;
+		while (n < capacity)
+		{
+			if (n > size_type(-1) / 2 / sizeof(T))
+				throw std::length_error("spsc_queue capacity too large");
+			n <<= 1;
+		}
+		mpBuffer = (T*)allocate_memory(mAllocator, n * sizeof(T));
+		mMask = n - 1;
+	}
+
+
+	template <typename T, typename Allocator>
+	spsc_queue<T, Allocator>::~spsc_queue()
+	{
+		size_type tail = mTail.load(std::memory_order_relaxed);
+		for (size_type head = mHead.load(std::memory_order_relaxed); head != tail; ++head)
+			mpBuffer[head & mMask].~T();
+		MINISTLFree(mAllocator, mpBuffer, (mMask + 1) * sizeof(T));
+	}
+
+
+	template <typename T, typename Allocator>
+	inline bool spsc_queue<T, Allocator>::try_push(const T &value)
+	{
+		return try_emplace(value);
+	}
+
+
+	template <typename T, typename Allocator>
+	inline bool spsc_queue<T, Allocator>::try_push(T &&value)
+	{
+		return try_emplace(std::move(value));
+	}
+
+
+	template <typename T, typename Allocator>
+	template <typename...Args>
+	bool spsc_queue<T, Allocator>::try_emplace(Args&&...args)
+	{
+		size_type tail = mTail.load(std::memory_order_relaxed);
+		if (tail - mHeadCache > mMask)
+		{
+			mHeadCache = mHead.load(std::memory_order_acquire);
+			if (tail - mHeadCache > mMask)
+				return false;
+		}
+		::new(static_cast<void*>(mpBuffer + (tail & mMask))) T(std::forward<Args>(args)...);
+		mTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+
+	// pushes up to n elements from first and publishes them all at once,
+	// returns how many there was room for.
+	template <typename T, typename Allocator>
+	template <typename InputIterator>
+	typename spsc_queue<T, Allocator>::size_type
+	spsc_queue<T, Allocator>::push_n(InputIterator first, size_type n)
+	{
+		size_type free_slots = FreeSlots(n);
+		if (n > free_slots)
+			n = free_slots;
+
+		size_type tail = mTail.load(std::memory_order_relaxed);
+		size_type i = 0;
+		try
+		{
+			for (; i < n; ++i, ++first)
+				::new(static_cast<void*>(mpBuffer + ((tail + i) & mMask))) T(*first);
+		}
+		catch (...)
+		{
+			mTail.store(tail + i, std::memory_order_release);
+			throw;
+		}
+		mTail.store(tail + n, std::memory_order_release);
+		return n;
+	}
+
+
+	// the queue must not be empty.
+	template <typename T, typename Allocator>
+	inline typename spsc_queue<T, Allocator>::reference
+	spsc_queue<T, Allocator>::front()
+	{
+		return mpBuffer[mHead.load(std::memory_order_relaxed) & mMask];
+	}
+
+
+	// the queue must not be empty. mTailCache is kept at or past mHead,
+	// which the caller has seen to be behind mTail.
+	template <typename T, typename Allocator>
+	inline void spsc_queue<T, Allocator>::pop()
+	{
+		size_type head = mHead.load(std::memory_order_relaxed);
+		if (head == mTailCache)
+			mTailCache = head + 1;
+		mpBuffer[head & mMask].~T();
+		mHead.store(head + 1, std::memory_order_release);
+	}
+
+
+	template <typename T, typename Allocator>
+	bool spsc_queue<T, Allocator>::try_pop(T &value)
+	{
+		size_type head = mHead.load(std::memory_order_relaxed);
+		if (head == mTailCache)
+		{
+			mTailCache = mTail.load(std::memory_order_acquire);
+			if (head == mTailCache)
+				return false;
+		}
+		T *pSlot = mpBuffer + (head & mMask);
+		value = std::move(*pSlot);
+		pSlot->~T();
+		mHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+
+	// moves up to n elements to d_first and frees their slots at once,
+	// returns how many there were.
+	template <typename T, typename Allocator>
+	template <typename OutputIterator>
+	typename spsc_queue<T, Allocator>::size_type
+	spsc_queue<T, Allocator>::pop_n(OutputIterator d_first, size_type n)
+	{
+		size_type used_slots = UsedSlots(n);
+		if (n > used_slots)
+			n = used_slots;
+
+		size_type head = mHead.load(std::memory_order_relaxed);
+		size_type i = 0;
+		try
+		{
+			for (; i < n; ++i, ++d_first)
+			{
+				T *pSlot = mpBuffer + ((head + i) & mMask);
+				*d_first = std::move(*pSlot);
+				pSlot->~T();
+			}
+		}
+		catch (...)
+		{
+			mHead.store(head + i, std::memory_order_release);
+			throw;
+		}
+		mHead.store(head + n, std::memory_order_release);
+		return n;
+	}
+
+
+	template <typename T, typename Allocator>
+	inline bool spsc_queue<T, Allocator>::empty()const
+	{
+		return size() == 0;
+	}
+
+
+	template <typename T, typename Allocator>
+	inline typename spsc_queue<T, Allocator>::size_type
+	spsc_queue<T, Allocator>::size()const
+	{
+		size_type head = mHead.load(std::memory_order_acquire);
+		return mTail.load(std::memory_order_acquire) - head;
+	}
+
+
+	template <typename T, typename Allocator>
+	inline typename spsc_queue<T, Allocator>::size_type
+	spsc_queue<T, Allocator>::capacity()const
+	{
+		return mMask + 1;
+	}
+
+
+	template <typename T, typename Allocator>
+	inline const typename spsc_queue<T, Allocator>::allocator_type&
+	spsc_queue<T, Allocator>::get_allocator()const
+	{
+		return mAllocator;
+	}
+
+
+	// the producer's side: reads mHead again only when the cached copy
+	// leaves fewer than wanted slots.
+	template <typename T, typename Allocator>
+	typename spsc_queue<T, Allocator>::size_type
+	spsc_queue<T, Allocator>::FreeSlots(size_type wanted)
+	{
+		size_type tail = mTail.load(std::memory_order_relaxed);
+		if (mMask + 1 - (tail - mHeadCache) < wanted)
+			mHeadCache = mHead.load(std::memory_order_acquire);
+		return mMask + 1 - (tail - mHeadCache);
+	}
+
+
+	template <typename T, typename Allocator>
+	typename spsc_queue<T, Allocator>::size_type
+	spsc_queue<T, Allocator>::UsedSlots(size_type wanted)
+	{
+		size_type head = mHead.load(std::memory_order_relaxed);
+		if (mTailCache - head < wanted)
+			mTailCache = mTail.load(std::memory_order_acquire);
+		return mTailCache - head;
+	}
+}
+
+#endif
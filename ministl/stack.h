@@ -1,9 +1,9 @@
-#include <deque>
 #include <iostream>
+#include "deque.h"
 
 namespace ministl
 {
-	template <typename T, typename Container = std::deque<T>>
+	template <typename T, typename Container = deque<T>>
 	class stack
 	{
 	public:
@@ -12,9 +12,11 @@ namespace ministl
 		using size_type        = typename Container::size_type;
 		using reference        = typename Container::reference;
 		using const_reference  = typename Container::const_reference;
+		using allocator_type   = typename Container::allocator_type;
 
 		explicit stack(Container&& cont = Container());
 		explicit stack(const Container &cont);
+		explicit stack(const allocator_type &alloc);
 		stack(const stack &other);
 		stack(stack &&other);
 
@@ -29,6 +31,9 @@ namespace ministl
 		void                  pop();
 		void                  swap(stack &other);
 
+		allocator_type        get_allocator()const;
+		void                  set_allocator(const allocator_type &alloc);
+
 	protected:
 		Container c;
 	};
@@ -43,6 +48,11 @@ namespace ministl
 		: c(cont)
 	{}
 
+	template <typename T, typename Container>
+	stack<T, Container>::stack(const allocator_type &alloc)
+		: c(alloc)
+	{}
+
 	template <typename T, typename Container>
 	stack<T, Container>::stack(const stack &other)
 		: c(other.c)
@@ -50,7 +60,7 @@ namespace ministl
 
 	template <typename T, typename Container>
 	stack<T, Container>::stack(stack &&other)
-		: c(std::remove(other.c))
+		: c(std::move(other.c))
 	{}
 
 	template <typename T, typename Container>
@@ -109,6 +119,21 @@ namespace ministl
 		using std::swap;
 		swap(c, other.c);
 	}
+
+	template <typename T, typename Container>
+	inline typename stack<T, Container>::allocator_type
+	stack<T, Container>::get_allocator()const
+	{
+		return c.get_allocator();
+	}
+
+	// only for containers with a set_allocator, like list and forward_list.
+	template <typename T, typename Container>
+	inline void
+	stack<T, Container>::set_allocator(const allocator_type &alloc)
+	{
+		c.set_allocator(alloc);
+	}
 }
 
 int main(int argc, char const *argv[])
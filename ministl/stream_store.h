@@ -0,0 +1,216 @@
+#ifndef STREAM_STORE_H
+#define STREAM_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MINISTL_HAS_STREAM_STORE 1
+#else
+#define MINISTL_HAS_STREAM_STORE 0
+#endif
+
+#if MINISTL_HAS_STREAM_STORE && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define MINISTL_HAS_AVX_STREAM_STORE 1
+#else
+#define MINISTL_HAS_AVX_STREAM_STORE 0
+#endif
+
+namespace ministl
+{
+	/// Non-temporal (streaming) stores write around the cache, straight to
+	/// memory. Copies and fills much larger than the last level cache would
+	/// otherwise evict the working set of every other thread on the socket
+	/// for data that is not read again soon. fill and fill_n of algorithm.h,
+	/// and the POD paths of uninitialized_copy and uninitialized_move, switch
+	/// to them for ranges of at least stream_store_threshold() bytes.
+	///
+	/// The kernels use SSE2, which every x86-64 processor has, and AVX where
+	/// the processor running the program has it. Streaming stores are weakly
+	/// ordered, so every kernel ends with an sfence: once it returns, the
+	/// data is ordered before any later store, such as the one publishing
+	/// the buffer to another thread. Elsewhere everything falls back to
+	/// memmove and the plain loops.
+
+	enum
+	{
+		__STREAM_STORE_THRESHOLD = 1 << 23
+	};
+
+	inline std::atomic<size_t> &__stream_store_threshold()
+	{
+		static std::atomic<size_t> threshold(__STREAM_STORE_THRESHOLD);
+		return threshold;
+	}
+
+	inline size_t stream_store_threshold()
+	{
+		return __stream_store_threshold().load(std::memory_order_relaxed);
+	}
+
+	// sets the size, in bytes, from which copies and fills stream. It is
+	// best set to about the size of the last level cache; size_t(-1)
+	// turns streaming off.
+	inline void set_stream_store_threshold(size_t bytes)
+	{
+		__stream_store_threshold().store(bytes, std::memory_order_relaxed);
+	}
+
+	inline bool use_stream_store(size_t bytes)
+	{
+		return MINISTL_HAS_STREAM_STORE && bytes >= stream_store_threshold();
+	}
+
+#if MINISTL_HAS_STREAM_STORE
+	inline bool cpu_has_avx()
+	{
+#if MINISTL_HAS_AVX_STREAM_STORE
+		static const bool avx = (__builtin_cpu_init(), __builtin_cpu_supports("avx") != 0);
+		return avx;
+#else
+		return false;
+#endif
+	}
+
+	// the kernels below store count 16 byte blocks to dst, which is 16
+	// byte aligned, and end with an sfence.
+	inline void stream_copy_blocks_sse2(char *dst, const char *src, size_t count)
+	{
+		for (; count > 0; --count, dst += 16, src += 16)
+		{
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), block);
+		}
+		_mm_sfence();
+	}
+
+	inline void stream_fill_blocks_sse2(char *dst, const unsigned char *pattern, size_t count)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+		for (; count > 0; --count, dst += 16)
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), block);
+		_mm_sfence();
+	}
+
+#if MINISTL_HAS_AVX_STREAM_STORE
+	__attribute__((target("avx")))
+	inline void stream_copy_blocks_avx(char *dst, const char *src, size_t count)
+	{
+		if ((reinterpret_cast<uintptr_t>(dst) & 31) && count > 0)
+		{
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), block);
+			dst += 16, src += 16, --count;
+		}
+		for (; count >= 2; count -= 2, dst += 32, src += 32)
+		{
+			__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(dst), block);
+		}
+		if (count > 0)
+		{
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), block);
+		}
+		_mm_sfence();
+	}
+
+	__attribute__((target("avx")))
+	inline void stream_fill_blocks_avx(char *dst, const unsigned char *pattern, size_t count)
+	{
+		__m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+		if ((reinterpret_cast<uintptr_t>(dst) & 31) && count > 0)
+		{
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), half);
+			dst += 16, --count;
+		}
+		__m256i block = _mm256_set_m128i(half, half);
+		for (; count >= 2; count -= 2, dst += 32)
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(dst), block);
+		if (count > 0)
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), half);
+		_mm_sfence();
+	}
+#endif
+
+	inline void stream_copy_blocks(char *dst, const char *src, size_t count)
+	{
+#if MINISTL_HAS_AVX_STREAM_STORE
+		if (cpu_has_avx())
+			return stream_copy_blocks_avx(dst, src, count);
+#endif
+		stream_copy_blocks_sse2(dst, src, count);
+	}
+
+	inline void stream_fill_blocks(char *dst, const unsigned char *pattern, size_t count)
+	{
+#if MINISTL_HAS_AVX_STREAM_STORE
+		if (cpu_has_avx())
+			return stream_fill_blocks_avx(dst, pattern, count);
+#endif
+		stream_fill_blocks_sse2(dst, pattern, count);
+	}
+#endif
+
+	// copies bytes from src to dst with streaming stores. Overlapping
+	// ranges, and platforms without streaming stores, use memmove.
+	inline void stream_copy(void *dst, const void *src, size_t bytes)
+	{
+		char *d = static_cast<char*>(dst);
+		const char *s = static_cast<const char*>(src);
+
+#if MINISTL_HAS_STREAM_STORE
+		if (d + bytes <= s || s + bytes <= d)
+		{
+			size_t head = (16 - (reinterpret_cast<uintptr_t>(d) & 15)) & 15;
+			if (head > bytes)
+				head = bytes;
+			std::memcpy(d, s, head);
+			d += head, s += head, bytes -= head;
+
+			size_t count = bytes / 16;
+			stream_copy_blocks(d, s, count);
+			std::memcpy(d + count * 16, s + count * 16, bytes - count * 16);
+			return;
+		}
+#endif
+		std::memmove(d, s, bytes);
+	}
+
+	// fills the n objects at first with value using streaming stores.
+	// Returns false, having done nothing, when value cannot be repeated
+	// across a 16 byte block: sizeof(T) does not divide 16, or first is not
+	// aligned to sizeof(T).
+	template <typename T>
+	bool stream_fill(T *first, size_t n, const T &value)
+	{
+#if MINISTL_HAS_STREAM_STORE
+		if (16 % sizeof(T) != 0 || reinterpret_cast<uintptr_t>(first) % sizeof(T) != 0)
+			return false;
+
+		for (; n > 0 && (reinterpret_cast<uintptr_t>(first) & 15); --n, ++first)
+			*first = value;
+
+		unsigned char pattern[16];
+		for (size_t i = 0; i < 16; i += sizeof(T))
+			std::memcpy(pattern + i, &value, sizeof(T));
+
+		size_t count = n * sizeof(T) / 16;
+		stream_fill_blocks(reinterpret_cast<char*>(first), pattern, count);
+		first += count * 16 / sizeof(T);
+		n -= count * 16 / sizeof(T);
+
+		for (; n > 0; --n, ++first)
+			*first = value;
+		return true;
+#else
+		return false;
+#endif
+	}
+}
+
+#endif
@@ -1,3 +1,40 @@
+#ifndef SUB_ALLOC_H
+#define SUB_ALLOC_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include "chunk_source.h"
+#include "type_traits.h"
+
+// Define MINISTL_ALLOC_OWNER_TRACKING to 1 to make every thread the owner
+// of the chunks it carves, see __default_allocator below.
+#ifndef MINISTL_ALLOC_OWNER_TRACKING
+#define MINISTL_ALLOC_OWNER_TRACKING 0
+#endif
+
+// Define MINISTL_ALLOC_STATS to 1 to make __default_allocator count what
+// it does, see __default_allocator::stats below.
+#ifndef MINISTL_ALLOC_STATS
+#define MINISTL_ALLOC_STATS 0
+#endif
+
+// Define MINISTL_ALLOC_LOCK_FREE to 1 to make the threaded
+// __default_allocator share lock free free lists instead of keeping a
+// cache per thread, see __default_allocator below.
+#ifndef MINISTL_ALLOC_LOCK_FREE
+#define MINISTL_ALLOC_LOCK_FREE 0
+#endif
+
+#if MINISTL_ALLOC_LOCK_FREE && MINISTL_ALLOC_OWNER_TRACKING
+#error "MINISTL_ALLOC_LOCK_FREE and MINISTL_ALLOC_OWNER_TRACKING can not be used together"
+#endif
+
 namespace ministl
 {
 	enum
@@ -7,12 +44,140 @@ namespace ministl
 
 	enum
 	{
-		__MAX_ALLOCATE_SIZE = 128
+		// small size classes are spaced __ALIGN bytes apart up to this size.
+		__MAX_SMALL_SIZE = 128
+	};
+
+	enum
+	{
+		// medium size classes are spaced geometrically above __MAX_SMALL_SIZE,
+		// four classes per doubling, up to this size.
+		__MAX_ALLOCATE_SIZE = 4096
+	};
+
+	enum
+	{
+		// the strictest alignment served from the pool, one page. Nodes are
+		// carved at a multiple of the largest power of two dividing their
+		// class size, up to this.
+		__MAX_POOL_ALIGN = 4096
+	};
+
+	enum
+	{
+		__N_SMALL_LIST = __MAX_SMALL_SIZE / __ALIGN
+	};
+
+	enum
+	{
+		__N_CLASS_PER_DOUBLING = 4
+	};
+
+	enum
+	{
+		// 128 -> 256 -> 512 -> 1024 -> 2048 -> 4096
+		__N_MEDIUM_LIST = 5 * __N_CLASS_PER_DOUBLING
+	};
+
+	enum
+	{
+		__N_FREE_LIST = __N_SMALL_LIST + __N_MEDIUM_LIST
+	};
+
+	enum
+	{
+		// number of nodes carved by one refill of a small size class, and the
+		// batch size in which a thread cache exchanges them with the central
+		// pool.
+		__N_REFILL = 20
+	};
+
+	enum
+	{
+		// a refill of a medium size class carves about this many bytes, but
+		// never fewer than two nodes.
+		__MEDIUM_REFILL_BYTES = 8192
+	};
+
+	enum
+	{
+		__OWNER_TRACKING = MINISTL_ALLOC_OWNER_TRACKING
+	};
+
+	enum
+	{
+		__ALLOC_STATS = MINISTL_ALLOC_STATS
+	};
+
+	enum
+	{
+		__LOCK_FREE = MINISTL_ALLOC_LOCK_FREE
+	};
+
+	enum
+	{
+		__PAGE_MAP_BITS = 16
+	};
+
+	enum
+	{
+		// a lock free free list head keeps the node pointer in the low
+		// __TAG_SHIFT bits and a modification count in the rest.
+		__TAG_SHIFT = sizeof(void*) == 8 ? 48 : 32
+	};
+
+	enum
+	{
+		// allocate_batch carves its nodes in runs of at most this many bytes,
+		// so a huge batch does not ask for one huge chunk.
+		__MAX_BATCH_BYTES = 256 * 1024
+	};
+
+	enum
+	{
+		// the bounds of an adapted refill: at least this many nodes, and at
+		// most this many bytes (but never fewer nodes than at first).
+		__MIN_REFILL = 2,
+		__MAX_REFILL_BYTES = 32 * 1024
 	};
 
 	enum
 	{
-		__N_FREE_LIST = __MAX_ALLOCATE_SIZE / __ALIGN
+		// a refill of a size class grows its batch when its last one was at
+		// most __REFILL_HOT_GAP microseconds ago, and shrinks it when that
+		// was at least __REFILL_COLD_GAP ago. In between the batch stays as
+		// it is.
+		__REFILL_HOT_GAP = 1000,
+		__REFILL_COLD_GAP = 100000
+	};
+
+	/// allocator_stats
+	///
+	/// A snapshot of the counters of __default_allocator, see
+	/// __default_allocator::stats. Everything but heap_size stays zero unless
+	/// MINISTL_ALLOC_STATS is 1. A refill is one call that carves new nodes
+	/// from a chunk, and refill_nodes is the total number of nodes those
+	/// calls returned, so refill_nodes / refills is the average n_node of
+	/// chunk_alloc. bytes_in_use counts pooled nodes handed out and not yet
+	/// given back, bytes_in_free_lists counts carved nodes waiting in free
+	/// lists (of any thread). Requests too large for the pool are counted
+	/// by malloc_fallbacks and malloc_bytes instead. refill_size is the
+	/// batch the calling thread's next refill of each class asks for, see
+	/// __default_allocator::refill_size; it is filled in whatever
+	/// MINISTL_ALLOC_STATS is.
+	struct allocator_stats
+	{
+		size_t class_size[__N_FREE_LIST];
+		size_t refill_size[__N_FREE_LIST];
+		size_t allocations[__N_FREE_LIST];
+		size_t deallocations[__N_FREE_LIST];
+		size_t refills;
+		size_t refill_nodes;
+		size_t bytes_in_use;
+		size_t bytes_in_free_lists;
+		size_t malloc_fallbacks;
+		size_t malloc_bytes;
+		size_t heap_size;
 	};
 
 	/// The default allocator follows the style of how the 2nd level allocator
@@ -21,165 +186,1531 @@ namespace ministl
 	/// requirments, the first level allocator allocator_malloc will be called.
 	/// Note that this allocator ignores different types of allocated objects,
 	/// and offers a uniform interface like malloc/free in C.
-	template <bool threads>
+	///
+	/// Requests up to __MAX_SMALL_SIZE bytes are rounded up to a multiple of
+	/// __ALIGN as in SGI STL. Larger ones are rounded up to one of the medium
+	/// size classes (160, 192, 224, 256, 320, ... 4096 bytes), and a refill
+	/// of a medium class starts with fewer nodes, see initial_refill_count.
+	/// From there the batch of each class adapts to how often it is
+	/// refilled, see refill_policy.
+	///
+	/// When threads is true, every thread allocates from and frees to its own
+	/// thread_cache without any locking. A cache refills from, and flushes
+	/// to, the free lists shared by all threads (the central pool) in
+	/// batches, so the central lock is taken once per batch instead of once
+	/// per node.
+	///
+	/// With __OWNER_TRACKING, a thread never touches the central pool. It
+	/// carves nodes from chunks it owns, and deallocate looks the owner of a
+	/// node up in the page map. A node freed by another thread is pushed
+	/// onto a lock free remote free list of its owner, which takes the whole
+	/// list back on its next refill of that size class.
+	///
+	/// With __LOCK_FREE, there are no thread caches at all. Every thread pops
+	/// from and pushes to the central free lists directly, with one CAS on a
+	/// head that packs the node pointer together with a count bumped by
+	/// every change (against ABA). Only carving new nodes takes the central
+	/// lock. This suits short lived threads that would never amortize a
+	/// cache. Chunks are never released in this mode (trim does nothing),
+	/// because a pop may still read the next pointer of a node it lost the
+	/// race for.
+	///
+	/// Chunks come from ChunkSource, see chunk_source.h: malloc by default,
+	/// or mmap_chunk_source / hugetlb_chunk_source for huge page backing.
+	///
+	/// Every chunk is recorded, so trim can give the chunks whose nodes are
+	/// all free back to the system. A trim also runs by itself once the
+	/// bytes freed since the last one pass the threshold set with
+	/// set_trim_threshold (0, the default, turns this off).
+	///
+	/// Every node is aligned to the largest power of two dividing its class
+	/// size, capped at __MAX_POOL_ALIGN. allocate(n, align) relies on this:
+	/// it rounds n up to a multiple of align, and the size class of that is
+	/// again a multiple of align, so any node of the class will do. Larger
+	/// alignments, or sizes beyond the pool, are served by allocator_malloc
+	/// with a little extra space to align the block in.
+	///
+	/// allocate_batch hands out many nodes of one size at once, carved
+	/// straight from a chunk, see allocator_traits in type_traits.h. Each of
+	/// them is given back with deallocate like any other node.
+	template <bool threads, typename ChunkSource = malloc_chunk_source>
 	class __default_allocator
 	{
 	public:
 		static void *allocate(size_t n);
+		static void *allocate(size_t n, size_t align);
+		static void *allocate_batch(size_t n, size_t n_batch);
 		static void deallocate(void *p, size_t n);
+		static void deallocate(void *p, size_t n, size_t align);
 
-	private:
-		static size_t round_up(size_t n);
-		static size_t freelist_index(size_t n);
+		static size_t trim();
+		static void   set_trim_threshold(size_t bytes);
 
-		static void *refill(size_t n);
-		static char *chunk_alloc(size_t n, int &n_node);
+		static allocator_stats stats();
+		static void            dump_stats(std::FILE *out = stderr);
+
+		static int refill_size(size_t n);
 
 	private:
+		// pool_resource keeps pools of its own with the same size classes.
+		template <bool> friend class pool_resource;
 
 		union free_list_node
 		{
 			free_list_node *next;
+		};
+
+		struct thread_cache;
+
+		typedef uint64_t tagged_node;
+
+		/// refill_policy
+		///
+		/// The refill batch of every size class, for the central pool or for
+		/// one thread cache. last_refill is when each class was last refilled,
+		/// in microseconds of a steady clock, so the time between two refills
+		/// tells how fast the class is used up, whatever the other classes
+		/// do. A hot class doubles
+		/// its batch, up to __MAX_REFILL_BYTES worth of nodes, and a cold one
+		/// halves it, down to __MIN_REFILL. Zero means the initial batch, so
+		/// a zero initialized policy needs no constructor.
+		struct refill_policy
+		{
+			int      n_node[__N_FREE_LIST];
+			uint64_t last_refill[__N_FREE_LIST];
+		};
 
+		/// stat_counters
+		///
+		/// Every set of counters is written by a single thread at a time (its
+		/// thread cache's, or whoever holds the central lock), so a relaxed
+		/// load and store is enough, and stats only has to add them up.
+		struct stat_counters
+		{
+			std::atomic<size_t> allocations[__N_FREE_LIST];
+			std::atomic<size_t> deallocations[__N_FREE_LIST];
+			std::atomic<size_t> refills;
+			std::atomic<size_t> refill_nodes;
+			std::atomic<size_t> carved_bytes;
+			std::atomic<size_t> malloc_fallbacks;
+			std::atomic<size_t> malloc_bytes;
+		};
+
+		/// chunk_header
+		///
+		/// Sits at the beginning of every chunk. The nodes of the chunk are
+		/// carved from [begin, begin + size). owner is null for the chunks of
+		/// the central pool, and free_bytes is only meaningful during trim.
+		struct chunk_header
+		{
+			char         *begin;
+			size_t        size;
+			thread_cache *owner;
+			chunk_header *next;
+			size_t        free_bytes;
+		};
+
+		/// thread_cache
+		///
+		/// The per thread front end used when threads is true. It holds one
+		/// free list per size class. A cache is never freed: when its thread
+		/// exits it is parked on the abandoned list, and the next new thread
+		/// adopts it. Without owner tracking the nodes are given back to the
+		/// central pool first; with it they stay, together with the chunks
+		/// and remote free lists, so frees still in flight find their owner.
+		struct thread_cache
+		{
+			free_list_node              *free_list[__N_FREE_LIST];
+			size_t                       count[__N_FREE_LIST];
+			std::atomic<free_list_node*> remote_free[__N_FREE_LIST];
+			char                        *free_begin;
+			char                        *free_end;
+			chunk_header                *chunks;
+			size_t                       freed_since_trim;
+			stat_counters                counters;
+			refill_policy                policy;
+			thread_cache                *next_abandoned;
+			thread_cache                *next_cache;
+
+			thread_cache();
 		};
 
-		static free_list_node *volatile free_list[__N_FREE_LIST];
+		struct cache_holder
+		{
+			thread_cache *cache;
+
+			cache_holder();
+			~cache_holder();
+		};
+
+	private:
+		static size_t round_up(size_t n);
+		static size_t freelist_index(size_t n);
+		static size_t class_size(size_t index);
+		static size_t class_align(size_t size);
+		static size_t fit_class(char *p, size_t bytes);
+		static int    initial_refill_count(size_t index);
+		static int    max_refill_count(size_t index);
+		static int    refill_count(const refill_policy &policy, size_t index);
+		static int    next_refill_count(refill_policy &policy, size_t index);
+		static refill_policy &local_policy();
+
+		static void *aligned_malloc(size_t n, size_t align);
+		static void  aligned_free(void *p, size_t n, size_t align);
+
+		static void *refill(size_t n);
+		static char *chunk_alloc(size_t n, int &n_node, stat_counters &counters);
+		static char *batch_alloc(size_t n, int &n_node, stat_counters &counters);
+		static void  cut_into_free_lists(char *begin, char *end, stat_counters &counters);
+		static void  cut_into_free_lists(thread_cache &cache, char *begin, char *end);
+		static free_list_node *link_nodes(char *chunk, size_t n, int n_node);
+
+		static thread_cache &local_cache();
+		static thread_cache *acquire_cache();
+		static void release_cache(thread_cache *cache);
+		static void *fetch_from_central(thread_cache &cache, size_t n);
+		static bool flush_to_central(thread_cache &cache, size_t index, size_t n_node);
+
+		static free_list_node *load_next(free_list_node *node);
+		static void store_next(free_list_node *node, free_list_node *next);
+		static free_list_node *lock_free_pop(size_t index);
+		static void lock_free_push(size_t index, free_list_node *first, free_list_node *last);
+		static void *lock_free_refill(size_t n);
+
+		static void *fetch_from_owned(thread_cache &cache, size_t n);
+		static char *owned_chunk_alloc(thread_cache &cache, size_t n, int &n_node);
+		static void remote_free(thread_cache *owner, size_t index, free_list_node *q);
+
+		static chunk_header *new_chunk(size_t bytes, thread_cache *owner, bool may_fail);
+		static void register_chunk(chunk_header *chunk, char *base, size_t size);
+		static chunk_header *chunk_of(void *p);
+
+		static stat_counters &local_counters();
+		static void count(std::atomic<size_t> &counter, size_t delta);
+
+		template <typename FreeList>
+		static size_t release_free_chunks(FreeList *lists, size_t *counts, chunk_header *&chunk_list,
+		                                  char *&begin, char *&end);
+
+	private:
+		static free_list_node *free_list[__N_FREE_LIST];
+		static std::atomic<tagged_node> tagged_free_list[__N_FREE_LIST];
 		static char *free_begin;
 		static char *free_end;
+		static std::atomic<size_t> heap_size;
+		static std::mutex central_lock;
+		static thread_cache *abandoned;
+		static thread_cache *all_caches;
+		static stat_counters central_counters;
+		static refill_policy central_policy;
+		static chunk_header *chunks;
+		static size_t freed_since_trim;
+		static std::atomic<size_t> trim_threshold;
+
+		static std::mutex page_map_lock;
+		static std::atomic<std::atomic<chunk_header*>*> page_map[1 << __PAGE_MAP_BITS];
 	};
 
-	template <typename threads>
-	__default_allocator<threads>::free_list_node *volatile __default_allocator<threads>::free_list[__N_FREE_LIST] = {0};
+	template <bool threads, typename ChunkSource>
+	typename __default_allocator<threads, ChunkSource>::free_list_node *__default_allocator<threads, ChunkSource>::free_list[__N_FREE_LIST] = {0};
+
+	template <bool threads, typename ChunkSource>
+	std::atomic<typename __default_allocator<threads, ChunkSource>::tagged_node>
+	__default_allocator<threads, ChunkSource>::tagged_free_list[__N_FREE_LIST];
+
+	template <bool threads, typename ChunkSource>
+	char *__default_allocator<threads, ChunkSource>::free_begin = nullptr;
+
+	template <bool threads, typename ChunkSource>
+	char *__default_allocator<threads, ChunkSource>::free_end = nullptr;
+
+	template <bool threads, typename ChunkSource>
+	std::atomic<size_t> __default_allocator<threads, ChunkSource>::heap_size(0);
+
+	template <bool threads, typename ChunkSource>
+	std::mutex __default_allocator<threads, ChunkSource>::central_lock;
 
-	template <typename threads>
-	char *__default_allocator<threads>::free_begin = nullptr;
+	template <bool threads, typename ChunkSource>
+	typename __default_allocator<threads, ChunkSource>::thread_cache *__default_allocator<threads, ChunkSource>::abandoned = nullptr;
 
-	template <typename threads>
-	char *__default_allocator<threads>::free_end = nullptr;
+	template <bool threads, typename ChunkSource>
+	typename __default_allocator<threads, ChunkSource>::thread_cache *__default_allocator<threads, ChunkSource>::all_caches = nullptr;
 
-	template <bool threads>
-	void *__default_allocator<threads>::allocate(size_t n)
+	template <bool threads, typename ChunkSource>
+	typename __default_allocator<threads, ChunkSource>::stat_counters __default_allocator<threads, ChunkSource>::central_counters;
+
+	template <bool threads, typename ChunkSource>
+	typename __default_allocator<threads, ChunkSource>::refill_policy __default_allocator<threads, ChunkSource>::central_policy;
+
+	template <bool threads, typename ChunkSource>
+	typename __default_allocator<threads, ChunkSource>::chunk_header *__default_allocator<threads, ChunkSource>::chunks = nullptr;
+
+	template <bool threads, typename ChunkSource>
+	size_t __default_allocator<threads, ChunkSource>::freed_since_trim = 0;
+
+	template <bool threads, typename ChunkSource>
+	std::atomic<size_t> __default_allocator<threads, ChunkSource>::trim_threshold(0);
+
+	template <bool threads, typename ChunkSource>
+	std::mutex __default_allocator<threads, ChunkSource>::page_map_lock;
+
+	template <bool threads, typename ChunkSource>
+	std::atomic<std::atomic<typename __default_allocator<threads, ChunkSource>::chunk_header*>*>
+	__default_allocator<threads, ChunkSource>::page_map[1 << __PAGE_MAP_BITS];
+
+	template <bool threads, typename ChunkSource>
+	void *__default_allocator<threads, ChunkSource>::allocate(size_t n)
 	{
 		if (n > __MAX_ALLOCATE_SIZE)
+		{
+			if (__ALLOC_STATS)
+			{
+				count(local_counters().malloc_fallbacks, 1);
+				count(local_counters().malloc_bytes, n);
+			}
 			return allocator_malloc::allocate(n);
+		}
+
+		if (threads && __LOCK_FREE)
+		{
+			size_t i = freelist_index(n);
+			free_list_node *result = lock_free_pop(i);
+
+			if (__ALLOC_STATS)
+				count(central_counters.allocations[i], 1);
+
+			if (!result)
+				return lock_free_refill(class_size(i));
+			return result;
+		}
+
+		if (threads)
+		{
+			thread_cache &cache = local_cache();
+			size_t i = freelist_index(n);
+			free_list_node *result = cache.free_list[i];
+
+			if (__ALLOC_STATS)
+				count(cache.counters.allocations[i], 1);
+
+			if (!result)
+			{
+				if (__OWNER_TRACKING)
+					return fetch_from_owned(cache, class_size(i));
+				return fetch_from_central(cache, class_size(i));
+			}
+
+			cache.free_list[i] = result->next;
+			--cache.count[i];
+			return result;
+		}
 
-		free_list_node *volatile *index = free_list + freelist_index(n);
+		size_t i = freelist_index(n);
+		free_list_node **index = free_list + i;
 		free_list_node *result = *index;
 
+		if (__ALLOC_STATS)
+			count(central_counters.allocations[i], 1);
+
 		if (!result)
-			return refill(round_up(n));
+			return refill(class_size(i));
 
 		*index = result->next;
 		return result;
 	}
 
-	template <bool threads>
-	void __default_allocator<threads>::deallocate(void *p, size_t n)
+	template <bool threads, typename ChunkSource>
+	void *__default_allocator<threads, ChunkSource>::allocate(size_t n, size_t align)
+	{
+		if (align <= __ALIGN)
+			return allocate(n);
+
+		size_t size = (n + align - 1) & ~(align - 1);
+		if (align > __MAX_POOL_ALIGN || size > __MAX_ALLOCATE_SIZE)
+			return aligned_malloc(n, align);
+
+		return allocate(size);
+	}
+
+	// over-allocates from allocator_malloc and keeps the pointer it returned
+	// right before the aligned block.
+	template <bool threads, typename ChunkSource>
+	void *__default_allocator<threads, ChunkSource>::aligned_malloc(size_t n, size_t align)
+	{
+		size_t bytes = n + align + sizeof(void*);
+
+		if (__ALLOC_STATS)
+		{
+			count(local_counters().malloc_fallbacks, 1);
+			count(local_counters().malloc_bytes, bytes);
+		}
+
+		char *raw = static_cast<char*>(allocator_malloc::allocate(bytes));
+		uintptr_t first = reinterpret_cast<uintptr_t>(raw + sizeof(void*));
+		char *result = reinterpret_cast<char*>((first + align - 1) & ~(static_cast<uintptr_t>(align) - 1));
+		reinterpret_cast<char**>(result)[-1] = raw;
+		return result;
+	}
+
+	template <bool threads, typename ChunkSource>
+	void __default_allocator<threads, ChunkSource>::aligned_free(void *p, size_t n, size_t align)
+	{
+		size_t bytes = n + align + sizeof(void*);
+
+		if (__ALLOC_STATS)
+			count(local_counters().malloc_bytes, -bytes);
+
+		allocator_malloc::deallocate(static_cast<char**>(p)[-1], bytes);
+	}
+
+	// returns n_batch nodes of n bytes, each holding a void* to the next one
+	// in its first word. The nodes are not taken off the free lists but
+	// carved from the current chunk, so they lie one after the other in
+	// the order of the run, except where one chunk runs out and the next
+	// begins.
+	template <bool threads, typename ChunkSource>
+	void *__default_allocator<threads, ChunkSource>::allocate_batch(size_t n, size_t n_batch)
+	{
+		void *head = nullptr;
+		void **link = &head;
+
+		if (n > __MAX_ALLOCATE_SIZE)
+		{
+			try
+			{
+				for (; n_batch > 0; --n_batch)
+				{
+					*link = allocate(n);
+					link = static_cast<void**>(*link);
+				}
+			}
+			catch (...)
+			{
+				*link = nullptr;
+				while (head)
+				{
+					void *next = *static_cast<void**>(head);
+					deallocate(head, n);
+					head = next;
+				}
+				throw;
+			}
+			*link = nullptr;
+			return head;
+		}
+
+		size_t i = freelist_index(n);
+		n = class_size(i);
+
+		size_t max_node = __MAX_BATCH_BYTES / n;
+		if (max_node == 0)
+			max_node = 1;
+
+		// taken before the central lock, the first call of a thread sets up
+		// its cache, which locks it too.
+		stat_counters &counters = local_counters();
+
+		while (n_batch > 0)
+		{
+			int n_node = static_cast<int>(n_batch < max_node ? n_batch : max_node);
+			char *run = batch_alloc(n, n_node, counters);
+
+			if (__ALLOC_STATS)
+			{
+				count(counters.allocations[i], n_node);
+				count(counters.refills, 1);
+				count(counters.refill_nodes, n_node);
+				count(counters.carved_bytes, n * n_node);
+			}
+
+			for (int k = 0; k < n_node; ++k, run += n)
+			{
+				*link = run;
+				link = reinterpret_cast<void**>(run);
+			}
+			n_batch -= n_node;
+		}
+
+		*link = nullptr;
+		return head;
+	}
+
+	template <bool threads, typename ChunkSource>
+	void __default_allocator<threads, ChunkSource>::deallocate(void *p, size_t n)
 	{
 		if (n > __MAX_ALLOCATE_SIZE)
-			return allocator_malloc.deallocate(p, n);
+		{
+			if (__ALLOC_STATS)
+				count(local_counters().malloc_bytes, -n);
+			return allocator_malloc::deallocate(p, n);
+		}
 
-		free_list_node *volatile *index = free_list + freelist_index(n);
 		free_list_node *q = static_cast<free_list_node*>(p);
+
+		if (threads && __LOCK_FREE)
+		{
+			size_t i = freelist_index(n);
+			lock_free_push(i, q, q);
+
+			if (__ALLOC_STATS)
+				count(central_counters.deallocations[i], 1);
+			return;
+		}
+
+		if (threads)
+		{
+			thread_cache &cache = local_cache();
+			size_t i = freelist_index(n);
+
+			if (__ALLOC_STATS)
+				count(cache.counters.deallocations[i], 1);
+
+			if (__OWNER_TRACKING)
+			{
+				thread_cache *owner = chunk_of(p)->owner;
+				if (owner != &cache)
+					return remote_free(owner, i, q);
+			}
+
+			q->next = cache.free_list[i];
+			cache.free_list[i] = q;
+
+			size_t threshold = trim_threshold.load(std::memory_order_relaxed);
+
+			if (__OWNER_TRACKING)
+			{
+				++cache.count[i];
+				cache.freed_since_trim += n;
+				if (threshold > 0 && cache.freed_since_trim >= threshold)
+					trim();
+			}
+			// a thread cache gives a batch back to the central pool once the
+			// free list holds two batches.
+			else if (++cache.count[i] > 2 * static_cast<size_t>(refill_count(cache.policy, i)))
+			{
+				if (flush_to_central(cache, i, refill_count(cache.policy, i)))
+					trim();
+			}
+			return;
+		}
+
+		size_t i = freelist_index(n);
+		free_list_node **index = free_list + i;
 		q->next = *index;
 		*index = q;
+
+		if (__ALLOC_STATS)
+			count(central_counters.deallocations[i], 1);
+
+		size_t threshold = trim_threshold.load(std::memory_order_relaxed);
+		freed_since_trim += n;
+		if (threshold > 0 && freed_since_trim >= threshold)
+			trim();
 	}
 
-	template <bool threads>
-	void *__default_allocator<threads>::refill(size_t n)
+	// p, n and align must be those given to and returned by allocate.
+	template <bool threads, typename ChunkSource>
+	void __default_allocator<threads, ChunkSource>::deallocate(void *p, size_t n, size_t align)
 	{
-		// allocate 20 memory chunks by default.
-		int n_node = 20;
-		char *chunk = chunk_alloc(n, n_node);
+		if (align <= __ALIGN)
+			return deallocate(p, n);
 
-		// when there is only one memeory chunk successfully allocated,
-		// return directly the newly allocated chunk, note that there are
-		// no spare chunks in free list.
-		if (n_node == 1)
-			return chunk;
+		size_t size = (n + align - 1) & ~(align - 1);
+		if (align > __MAX_POOL_ALIGN || size > __MAX_ALLOCATE_SIZE)
+			return aligned_free(p, n, align);
+
+		deallocate(p, size);
+	}
 
-		free_list_node *volatile *index = free_list + freelist_index(n);
-		*index = static_cast<free_list_node*>(chunk + n);
-		free_list_node *current, *next = *index;
+	// gives every chunk whose nodes are all free back to the system, and
+	// returns the number of bytes released. With threads, the calling
+	// thread's cache is flushed to the central pool first, and nodes held
+	// by other threads' caches keep their chunks alive. With owner tracking
+	// only the chunks owned by the calling thread are considered.
+	template <bool threads, typename ChunkSource>
+	size_t __default_allocator<threads, ChunkSource>::trim()
+	{
+		if (threads && __LOCK_FREE)
+			return 0;
 
-		for (int i = 1;; ++i)
+		if (threads && __OWNER_TRACKING)
 		{
-			current = next;
-			if (i + 1 == n_node)
+			thread_cache &cache = local_cache();
+			for (size_t i = 0; i < __N_FREE_LIST; ++i)
 			{
-				current->next = 0;
-				break;
+				free_list_node *head = cache.remote_free[i].exchange(nullptr, std::memory_order_acquire);
+				while (head)
+				{
+					free_list_node *next = head->next;
+					head->next = cache.free_list[i];
+					cache.free_list[i] = head;
+					++cache.count[i];
+					head = next;
+				}
 			}
-			else
+
+			cache.freed_since_trim = 0;
+			return release_free_chunks(cache.free_list, cache.count, cache.chunks,
+			                           cache.free_begin, cache.free_end);
+		}
+
+		if (threads)
+		{
+			thread_cache &cache = local_cache();
+			for (size_t i = 0; i < __N_FREE_LIST; ++i)
 			{
-				next = static_cast<free_list_node*>(static_cast<char*>(next + n));
-				current->next = next;
+				if (cache.count[i] > 0)
+					flush_to_central(cache, i, cache.count[i]);
 			}
 		}
 
+		std::lock_guard<std::mutex> lock(central_lock);
+		freed_since_trim = 0;
+		return release_free_chunks(free_list, static_cast<size_t*>(nullptr), chunks, free_begin, free_end);
+	}
+
+	template <bool threads, typename ChunkSource>
+	void __default_allocator<threads, ChunkSource>::set_trim_threshold(size_t bytes)
+	{
+		trim_threshold.store(bytes, std::memory_order_relaxed);
+	}
+
+	template <bool threads, typename ChunkSource>
+	void *__default_allocator<threads, ChunkSource>::refill(size_t n)
+	{
+		// allocate 20 memory chunks at first, fewer for medium sizes.
+		int n_node = next_refill_count(central_policy, freelist_index(n));
+		char *chunk = chunk_alloc(n, n_node, central_counters);
+
+		if (__ALLOC_STATS)
+		{
+			count(central_counters.refills, 1);
+			count(central_counters.refill_nodes, n_node);
+			count(central_counters.carved_bytes, n * n_node);
+		}
+
+		// when there is only one memeory chunk successfully allocated,
+		// return directly the newly allocated chunk, note that there are
+		// no spare chunks in free list.
+		if (n_node == 1)
+			return chunk;
+
+		free_list[freelist_index(n)] = link_nodes(chunk + n, n, n_node - 1);
 		return chunk;
 	}
 
-	template <bool threads>
-	char *__default_allocator<threads>::chunk_alloc(size_t n, int &n_node)
+	template <bool threads, typename ChunkSource>
+	char *__default_allocator<threads, ChunkSource>::chunk_alloc(size_t n, int &n_node, stat_counters &counters)
 	{
 		size_t total_bytes = n * n_node;
 		size_t bytes_left = free_end - free_begin;
+		size_t gap = (0 - reinterpret_cast<uintptr_t>(free_begin)) & (class_align(n) - 1);
 
 		char *result;
 
-		if (bytes_left >= total_bytes)
+		// the nodes start at a multiple of class_align(n), the bytes skipped
+		// to get there go to the free lists of smaller classes.
+		if (bytes_left >= gap + n)
 		{
-			result = free_begin;
-			free_begin += total_bytes;
-			return result;
-		}
-		else if (bytes_left >= n)
-		{
-			n_node = bytes_left / n;
+			cut_into_free_lists(free_begin, free_begin + gap, counters);
+			free_begin += gap;
+			bytes_left -= gap;
+
+			if (bytes_left < total_bytes)
+				n_node = bytes_left / n;
 			result = free_begin;
 			free_begin += n_node * n;
 			return result;
 		}
 
-		if (bytes_left >= __ALIGN)
-		{
-			free_list *volatile *index = free_list + freelist_index(bytes_left);
-			free_list *begin = static_cast<free_list_node*>(free_begin);
-			begin->next = *index;
-			*index = begin;
-		}
+		// put the tail of the current chunk into free lists so that it is
+		// not wasted when a new chunk is obtained.
+		cut_into_free_lists(free_begin, free_end, counters);
+		free_begin = free_end;
 
-		size_t bytes_to_alloc = total_bytes << 1 + round_up(heap_size >> 4);
+		size_t bytes_to_alloc = (total_bytes << 1) + round_up(heap_size >> 4);
 
-		free_begin = static_cast<char*>(std::malloc(bytes_to_alloc));
-		if (!free_begin)
+		chunk_header *chunk = new_chunk(bytes_to_alloc, nullptr, true);
+		if (!chunk)
 		{
-			free_list *volatile *index
-			for (int i = n; i <= __MAX_ALLOCATE_SIZE; i += __ALIGN)
+			// try to borrow a node from a free list of larger nodes.
+			for (size_t i = freelist_index(n); i < __N_FREE_LIST; ++i)
 			{
-				index = free_list + freelist_index(i);
-				if (*index)
+				free_list_node *node;
+				if (threads && __LOCK_FREE)
+				{
+					node = lock_free_pop(i);
+				}
+				else
+				{
+					free_list_node **index = free_list + i;
+					node = *index;
+					if (node)
+						*index = node->next;
+				}
+
+				if (node)
 				{
-					*index = (*index)->next;
-					free_begin = static_cast<char*>(*index);
-					free_end = free_begin + i;
-					return chunk_alloc(n, n_node);
+					free_begin = reinterpret_cast<char*>(node);
+					free_end = free_begin + class_size(i);
+
+					// the node will be carved again
+					if (__ALLOC_STATS)
+						count(counters.carved_bytes, -class_size(i));
+					return chunk_alloc(n, n_node, counters);
 				}
 			}
 
-			free_end = nullptr;
-			free_begin = static_cast<char*>(allocator_malloc::allocate(bytes_to_alloc));
+			chunk = new_chunk(bytes_to_alloc, nullptr, false);
 		}
 
-		heap_size += bytes_to_alloc;
-		free_end = free_end + bytes_to_alloc;
-		return chunk_alloc(n, n_node);
+		free_begin = chunk->begin;
+		free_end = chunk->begin + chunk->size;
+		return chunk_alloc(n, n_node, counters);
 	}
 
-	template <bool threads>
-	size_t __default_allocator<threads>::freelist_index(size_t n)
+	// carves up to n_node contiguous nodes of n bytes for allocate_batch
+	// from wherever this thread gets its chunks, and sets n_node to the
+	// number carved. counters are the calling thread's, obtained before
+	// the central lock is taken.
+	template <bool threads, typename ChunkSource>
+	char *__default_allocator<threads, ChunkSource>::batch_alloc(size_t n, int &n_node, stat_counters &counters)
 	{
-		return (n + __ALIGN - 1) / __ALIGN - 1;
-	}
-}
\ No newline at end of file
+		if (threads && __OWNER_TRACKING)
+			return owned_chunk_alloc(local_cache(), n, n_node);
+
+		if (threads)
+		{
+			std::lock_guard<std::mutex> lock(central_lock);
+			return chunk_alloc(n, n_node, counters);
+		}
+
+		return chunk_alloc(n, n_node, counters);
+	}
+
+	// puts [begin, end) into the central free lists, cut into the largest
+	// nodes that fit and are aligned as their class requires. The caller
+	// holds the central lock when threads is true.
+	template <bool threads, typename ChunkSource>
+	void __default_allocator<threads, ChunkSource>::cut_into_free_lists(char *begin, char *end, stat_counters &counters)
+	{
+		while (end - begin >= __ALIGN)
+		{
+			size_t i = fit_class(begin, end - begin);
+
+			free_list_node *node = reinterpret_cast<free_list_node*>(begin);
+			if (threads && __LOCK_FREE)
+			{
+				lock_free_push(i, node, node);
+			}
+			else
+			{
+				node->next = free_list[i];
+				free_list[i] = node;
+			}
+			begin += class_size(i);
+
+			if (__ALLOC_STATS)
+				count(counters.carved_bytes, class_size(i));
+		}
+	}
+
+	// the same for the free lists of cache.
+	template <bool threads, typename ChunkSource>
+	void __default_allocator<threads, ChunkSource>::cut_into_free_lists(thread_cache &cache, char *begin, char *end)
+	{
+		while (end - begin >= __ALIGN)
+		{
+			size_t i = fit_class(begin, end - begin);
+
+			free_list_node *node = reinterpret_cast<free_list_node*>(begin);
+			node->next = cache.free_list[i];
+			cache.free_list[i] = node;
+			++cache.count[i];
+			begin += class_size(i);
+
+			if (__ALLOC_STATS)
+				count(cache.counters.carved_bytes, class_size(i));
+		}
+	}
+
+	// links n_node nodes of n bytes, which lie contiguously from chunk,
+	// into a null terminated free list and returns its head.
+	template <bool threads, typename ChunkSource>
+	typename __default_allocator<threads, ChunkSource>::free_list_node*
+	__default_allocator<threads, ChunkSource>::link_nodes(char *chunk, size_t n, int n_node)
+	{
+		free_list_node *head = reinterpret_cast<free_list_node*>(chunk);
+		free_list_node *current = head;
+
+		for (int i = 1; i < n_node; ++i)
+		{
+			chunk += n;
+			current->next = reinterpret_cast<free_list_node*>(chunk);
+			current = current->next;
+		}
+
+		current->next = nullptr;
+		return head;
+	}
+
+	template <bool threads, typename ChunkSource>
+	inline size_t __default_allocator<threads, ChunkSource>::round_up(size_t n)
+	{
+		return (n + __ALIGN - 1) & ~(static_cast<size_t>(__ALIGN) - 1);
+	}
+
+	// returns the index of the smallest size class holding n bytes.
+	template <bool threads, typename ChunkSource>
+	inline size_t __default_allocator<threads, ChunkSource>::freelist_index(size_t n)
+	{
+		if (n <= __MAX_SMALL_SIZE)
+			return (n + __ALIGN - 1) / __ALIGN - 1;
+
+		size_t base = __MAX_SMALL_SIZE;
+		size_t index = __N_SMALL_LIST;
+		while (n > base << 1)
+		{
+			base <<= 1;
+			index += __N_CLASS_PER_DOUBLING;
+		}
+
+		return index + (n - base - 1) / (base / __N_CLASS_PER_DOUBLING);
+	}
+
+	template <bool threads, typename ChunkSource>
+	inline size_t __default_allocator<threads, ChunkSource>::class_size(size_t index)
+	{
+		if (index < __N_SMALL_LIST)
+			return (index + 1) * __ALIGN;
+
+		index -= __N_SMALL_LIST;
+		size_t base = static_cast<size_t>(__MAX_SMALL_SIZE) << (index / __N_CLASS_PER_DOUBLING);
+		return base + (index % __N_CLASS_PER_DOUBLING + 1) * (base / __N_CLASS_PER_DOUBLING);
+	}
+
+	// the alignment of every node of a class of size bytes.
+	template <bool threads, typename ChunkSource>
+	inline size_t __default_allocator<threads, ChunkSource>::class_align(size_t size)
+	{
+		size_t align = size & (0 - size);
+		return align < static_cast<size_t>(__MAX_POOL_ALIGN) ? align : static_cast<size_t>(__MAX_POOL_ALIGN);
+	}
+
+	// returns the largest class of at most bytes whose nodes may start at
+	// p. A medium sized range may fall between two classes, and p may not
+	// be aligned for the largest class that fits.
+	template <bool threads, typename ChunkSource>
+	inline size_t __default_allocator<threads, ChunkSource>::fit_class(char *p, size_t bytes)
+	{
+		if (bytes > __MAX_ALLOCATE_SIZE)
+			bytes = __MAX_ALLOCATE_SIZE;
+
+		size_t i = freelist_index(bytes);
+		if (class_size(i) > bytes)
+			--i;
+
+		while (i > 0 && (reinterpret_cast<uintptr_t>(p) & (class_align(class_size(i)) - 1)))
+			--i;
+		return i;
+	}
+
+	// the number of nodes carved by the first refill of the index-th size
+	// class.
+	template <bool threads, typename ChunkSource>
+	inline int __default_allocator<threads, ChunkSource>::initial_refill_count(size_t index)
+	{
+		if (index < __N_SMALL_LIST)
+			return __N_REFILL;
+
+		size_t n_node = __MEDIUM_REFILL_BYTES / class_size(index);
+		if (n_node > __N_REFILL)
+			return __N_REFILL;
+		return n_node < 2 ? 2 : static_cast<int>(n_node);
+	}
+
+	template <bool threads, typename ChunkSource>
+	inline int __default_allocator<threads, ChunkSource>::max_refill_count(size_t index)
+	{
+		int n_node = static_cast<int>(__MAX_REFILL_BYTES / class_size(index));
+		int initial = initial_refill_count(index);
+		return n_node > initial ? n_node : initial;
+	}
+
+	template <bool threads, typename ChunkSource>
+	inline int __default_allocator<threads, ChunkSource>::refill_count(const refill_policy &policy, size_t index)
+	{
+		return policy.n_node[index] ? policy.n_node[index] : initial_refill_count(index);
+	}
+
+	// called for every refill of the index-th class, adapts its batch to
+	// the time since its last one and returns it. Refills are rare enough
+	// to afford reading the clock.
+	template <bool threads, typename ChunkSource>
+	int __default_allocator<threads, ChunkSource>::next_refill_count(refill_policy &policy, size_t index)
+	{
+		int n_node = refill_count(policy, index);
+		uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+		                   std::chrono::steady_clock::now().time_since_epoch()).count() + 1;
+		uint64_t gap = now - policy.last_refill[index];
+		bool first = policy.last_refill[index] == 0;
+
+		policy.last_refill[index] = now;
+		if (first)
+			return policy.n_node[index] = n_node;
+
+		if (gap <= static_cast<uint64_t>(__REFILL_HOT_GAP))
+		{
+			int max_node = max_refill_count(index);
+			n_node = n_node * 2 < max_node ? n_node * 2 : max_node;
+		}
+		else if (gap >= static_cast<uint64_t>(__REFILL_COLD_GAP))
+		{
+			n_node = n_node / 2 > __MIN_REFILL ? n_node / 2 : __MIN_REFILL;
+		}
+
+		return policy.n_node[index] = n_node;
+	}
+
+	template <bool threads, typename ChunkSource>
+	inline typename __default_allocator<threads, ChunkSource>::refill_policy&
+	__default_allocator<threads, ChunkSource>::local_policy()
+	{
+		if (threads && !__LOCK_FREE)
+			return local_cache().policy;
+		return central_policy;
+	}
+
+	// returns the number of nodes the calling thread's next refill of n
+	// byte nodes asks for, before it adapts.
+	template <bool threads, typename ChunkSource>
+	int __default_allocator<threads, ChunkSource>::refill_size(size_t n)
+	{
+		if (threads && __LOCK_FREE)
+		{
+			std::lock_guard<std::mutex> lock(central_lock);
+			return refill_count(central_policy, freelist_index(n));
+		}
+		return refill_count(local_policy(), freelist_index(n));
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// thread_cache
+	///////////////////////////////////////////////////////////////////////
+
+	template <bool threads, typename ChunkSource>
+	__default_allocator<threads, ChunkSource>::thread_cache::thread_cache()
+		: free_begin(nullptr),
+		  free_end(nullptr),
+		  chunks(nullptr),
+		  freed_since_trim(0),
+		  counters(),
+		  policy(),
+		  next_abandoned(nullptr),
+		  next_cache(nullptr)
+	{
+		for (size_t i = 0; i < __N_FREE_LIST; ++i)
+		{
+			free_list[i] = nullptr;
+			count[i] = 0;
+			remote_free[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	template <bool threads, typename ChunkSource>
+	__default_allocator<threads, ChunkSource>::cache_holder::cache_holder()
+		: cache(acquire_cache())
+	{
+		// empty
+	}
+
+	template <bool threads, typename ChunkSource>
+	__default_allocator<threads, ChunkSource>::cache_holder::~cache_holder()
+	{
+		release_cache(cache);
+	}
+
+	template <bool threads, typename ChunkSource>
+	typename __default_allocator<threads, ChunkSource>::thread_cache&
+	__default_allocator<threads, ChunkSource>::local_cache()
+	{
+		static thread_local cache_holder holder;
+		return *holder.cache;
+	}
+
+	template <bool threads, typename ChunkSource>
+	typename __default_allocator<threads, ChunkSource>::thread_cache*
+	__default_allocator<threads, ChunkSource>::acquire_cache()
+	{
+		{
+			std::lock_guard<std::mutex> lock(central_lock);
+			if (abandoned)
+			{
+				thread_cache *cache = abandoned;
+				abandoned = cache->next_abandoned;
+				cache->next_abandoned = nullptr;
+				return cache;
+			}
+		}
+
+		void *p = std::malloc(sizeof(thread_cache));
+		if (!p)
+			p = allocator_malloc::allocate(sizeof(thread_cache));
+		thread_cache *cache = new(p) thread_cache();
+
+		std::lock_guard<std::mutex> lock(central_lock);
+		cache->next_cache = all_caches;
+		all_caches = cache;
+		return cache;
+	}
+
+	template <bool threads, typename ChunkSource>
+	void __default_allocator<threads, ChunkSource>::release_cache(thread_cache *cache)
+	{
+		if (!__OWNER_TRACKING)
+		{
+			for (size_t i = 0; i < __N_FREE_LIST; ++i)
+			{
+				if (cache->count[i] > 0)
+					flush_to_central(*cache, i, cache->count[i]);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(central_lock);
+		cache->next_abandoned = abandoned;
+		abandoned = cache;
+	}
+
+	// moves up to __N_REFILL nodes of n bytes from the central pool into
+	// cache, carving a new run from the current chunk when the central free
+	// list is empty. One node is returned to the caller directly.
+	template <bool threads, typename ChunkSource>
+	void *__default_allocator<threads, ChunkSource>::fetch_from_central(thread_cache &cache, size_t n)
+	{
+		size_t i = freelist_index(n);
+		int batch = next_refill_count(cache.policy, i);
+		free_list_node *head;
+		int n_node = 0;
+
+		{
+			std::lock_guard<std::mutex> lock(central_lock);
+
+			head = free_list[i];
+			if (head)
+			{
+				free_list_node *tail = head;
+				for (n_node = 1; n_node < batch && tail->next; ++n_node)
+					tail = tail->next;
+
+				free_list[i] = tail->next;
+				tail->next = nullptr;
+			}
+			else
+			{
+				n_node = batch;
+				char *chunk = chunk_alloc(n, n_node, cache.counters);
+				head = link_nodes(chunk, n, n_node);
+
+				if (__ALLOC_STATS)
+				{
+					count(cache.counters.refills, 1);
+					count(cache.counters.refill_nodes, n_node);
+					count(cache.counters.carved_bytes, n * n_node);
+				}
+			}
+		}
+
+		cache.free_list[i] = head->next;
+		cache.count[i] = n_node - 1;
+		return head;
+	}
+
+	// gives the first n_node nodes of the cache's i-th free list back to
+	// the central pool. The run is cut off before the lock is taken, so the
+	// critical section is a single splice. Returns true when the bytes given
+	// back since the last trim have passed the trim threshold.
+	template <bool threads, typename ChunkSource>
+	bool __default_allocator<threads, ChunkSource>::flush_to_central(thread_cache &cache, size_t index, size_t n_node)
+	{
+		free_list_node *head = cache.free_list[index];
+		free_list_node *tail = head;
+
+		for (size_t i = 1; i < n_node; ++i)
+			tail = tail->next;
+
+		cache.free_list[index] = tail->next;
+		cache.count[index] -= n_node;
+
+		size_t threshold = trim_threshold.load(std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(central_lock);
+		tail->next = free_list[index];
+		free_list[index] = head;
+
+		freed_since_trim += n_node * class_size(index);
+		return threshold > 0 && freed_since_trim >= threshold;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// lock free
+	///////////////////////////////////////////////////////////////////////
+
+	// a popper may read the next pointer of a node another thread has
+	// just popped and is pushing again, so on the lock free lists it is
+	// read and written atomically. Relaxed is enough, the tagged head
+	// orders everything else.
+	template <bool threads, typename ChunkSource>
+	inline typename __default_allocator<threads, ChunkSource>::free_list_node*
+	__default_allocator<threads, ChunkSource>::load_next(free_list_node *node)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return __atomic_load_n(&node->next, __ATOMIC_RELAXED);
+#else
+		return *static_cast<free_list_node *volatile*>(&node->next);
+#endif
+	}
+
+	template <bool threads, typename ChunkSource>
+	inline void __default_allocator<threads, ChunkSource>::store_next(free_list_node *node, free_list_node *next)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		__atomic_store_n(&node->next, next, __ATOMIC_RELAXED);
+#else
+		*static_cast<free_list_node *volatile*>(&node->next) = next;
+#endif
+	}
+
+	// pops the head of the index-th central free list. The next pointer of
+	// the head may be overwritten by whoever wins the race for it, but then
+	// the count in the head has changed too, and the CAS fails.
+	template <bool threads, typename ChunkSource>
+	typename __default_allocator<threads, ChunkSource>::free_list_node*
+	__default_allocator<threads, ChunkSource>::lock_free_pop(size_t index)
+	{
+		const tagged_node pointer_mask = (static_cast<tagged_node>(1) << __TAG_SHIFT) - 1;
+		std::atomic<tagged_node> &head = tagged_free_list[index];
+		tagged_node old_head = head.load(std::memory_order_acquire);
+
+		for (;;)
+		{
+			free_list_node *node = reinterpret_cast<free_list_node*>(static_cast<uintptr_t>(old_head & pointer_mask));
+			if (!node)
+				return nullptr;
+
+			tagged_node new_head = (reinterpret_cast<uintptr_t>(load_next(node)) & pointer_mask)
+			                     | ((old_head & ~pointer_mask) + (pointer_mask + 1));
+			if (head.compare_exchange_weak(old_head, new_head, std::memory_order_acquire,
+			                               std::memory_order_acquire))
+				return node;
+		}
+	}
+
+	// pushes the nodes first ... last, which are already linked, onto the
+	// index-th central free list.
+	template <bool threads, typename ChunkSource>
+	void __default_allocator<threads, ChunkSource>::lock_free_push(size_t index, free_list_node *first, free_list_node *last)
+	{
+		const tagged_node pointer_mask = (static_cast<tagged_node>(1) << __TAG_SHIFT) - 1;
+		std::atomic<tagged_node> &head = tagged_free_list[index];
+		tagged_node old_head = head.load(std::memory_order_relaxed);
+		tagged_node new_head;
+
+		do
+		{
+			store_next(last, reinterpret_cast<free_list_node*>(static_cast<uintptr_t>(old_head & pointer_mask)));
+			new_head = (reinterpret_cast<uintptr_t>(first) & pointer_mask)
+			         | ((old_head & ~pointer_mask) + (pointer_mask + 1));
+		} while (!head.compare_exchange_weak(old_head, new_head, std::memory_order_release,
+		                                     std::memory_order_relaxed));
+	}
+
+	// carves a run of n bytes nodes under the central lock, returns the
+	// first one and pushes the rest with a single CAS.
+	template <bool threads, typename ChunkSource>
+	void *__default_allocator<threads, ChunkSource>::lock_free_refill(size_t n)
+	{
+		size_t i = freelist_index(n);
+		int n_node;
+		char *chunk;
+
+		{
+			std::lock_guard<std::mutex> lock(central_lock);
+			n_node = next_refill_count(central_policy, i);
+			chunk = chunk_alloc(n, n_node, central_counters);
+
+			if (__ALLOC_STATS)
+			{
+				count(central_counters.refills, 1);
+				count(central_counters.refill_nodes, n_node);
+				count(central_counters.carved_bytes, n * n_node);
+			}
+		}
+
+		if (n_node > 1)
+		{
+			free_list_node *head = link_nodes(chunk + n, n, n_node - 1);
+			free_list_node *tail = reinterpret_cast<free_list_node*>(chunk + (n_node - 1) * n);
+			lock_free_push(i, head, tail);
+		}
+		return chunk;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// owner tracking
+	///////////////////////////////////////////////////////////////////////
+
+	// refills the cache's free list of n bytes nodes, first with everything
+	// other threads have freed to this cache, then from chunks it owns.
+	template <bool threads, typename ChunkSource>
+	void *__default_allocator<threads, ChunkSource>::fetch_from_owned(thread_cache &cache, size_t n)
+	{
+		size_t i = freelist_index(n);
+		free_list_node *head = cache.remote_free[i].exchange(nullptr, std::memory_order_acquire);
+		int n_node = 0;
+
+		if (head)
+		{
+			for (free_list_node *p = head; p; p = p->next)
+				++n_node;
+		}
+		else
+		{
+			n_node = next_refill_count(cache.policy, i);
+			char *chunk = owned_chunk_alloc(cache, n, n_node);
+			head = link_nodes(chunk, n, n_node);
+
+			if (__ALLOC_STATS)
+			{
+				count(cache.counters.refills, 1);
+				count(cache.counters.refill_nodes, n_node);
+				count(cache.counters.carved_bytes, n * n_node);
+			}
+		}
+
+		cache.free_list[i] = head->next;
+		cache.count[i] = n_node - 1;
+		return head;
+	}
+
+	// the same as chunk_alloc, except that the nodes are carved from the
+	// chunks owned by cache, and no lock is needed.
+	template <bool threads, typename ChunkSource>
+	char *__default_allocator<threads, ChunkSource>::owned_chunk_alloc(thread_cache &cache, size_t n, int &n_node)
+	{
+		size_t total_bytes = n * n_node;
+		size_t bytes_left = cache.free_end - cache.free_begin;
+		size_t gap = (0 - reinterpret_cast<uintptr_t>(cache.free_begin)) & (class_align(n) - 1);
+
+		char *result;
+
+		if (bytes_left >= gap + n)
+		{
+			cut_into_free_lists(cache, cache.free_begin, cache.free_begin + gap);
+			cache.free_begin += gap;
+			bytes_left -= gap;
+
+			if (bytes_left < total_bytes)
+				n_node = bytes_left / n;
+			result = cache.free_begin;
+			cache.free_begin += n_node * n;
+			return result;
+		}
+
+		cut_into_free_lists(cache, cache.free_begin, cache.free_end);
+		cache.free_begin = cache.free_end;
+
+		size_t bytes_to_alloc = (total_bytes << 1) + round_up(heap_size >> 4);
+		chunk_header *chunk = new_chunk(bytes_to_alloc, &cache, false);
+
+		cache.free_begin = chunk->begin;
+		cache.free_end = chunk->begin + chunk->size;
+		return owned_chunk_alloc(cache, n, n_node);
+	}
+
+	// pushes q onto owner's remote free list. Only the owner ever pops, and
+	// it always takes the whole list at once, so a plain CAS push is safe.
+	template <bool threads, typename ChunkSource>
+	void __default_allocator<threads, ChunkSource>::remote_free(thread_cache *owner, size_t index, free_list_node *q)
+	{
+		std::atomic<free_list_node*> &head = owner->remote_free[index];
+		free_list_node *next = head.load(std::memory_order_relaxed);
+
+		do
+		{
+			q->next = next;
+		}
+		while (!head.compare_exchange_weak(next, q, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// statistics
+	///////////////////////////////////////////////////////////////////////
+
+	// adds up the counters of the central pool and of every thread cache.
+	// Counters of running threads are read while they change, so the
+	// snapshot is only approximately consistent.
+	template <bool threads, typename ChunkSource>
+	allocator_stats __default_allocator<threads, ChunkSource>::stats()
+	{
+		allocator_stats result = allocator_stats();
+		for (size_t i = 0; i < __N_FREE_LIST; ++i)
+			result.refill_size[i] = refill_size(class_size(i));
+
+		std::lock_guard<std::mutex> lock(central_lock);
+
+		for (thread_cache *cache = all_caches;; cache = cache->next_cache)
+		{
+			const stat_counters &counters = cache ? cache->counters : central_counters;
+
+			for (size_t i = 0; i < __N_FREE_LIST; ++i)
+			{
+				result.allocations[i] += counters.allocations[i].load(std::memory_order_relaxed);
+				result.deallocations[i] += counters.deallocations[i].load(std::memory_order_relaxed);
+			}
+			result.refills += counters.refills.load(std::memory_order_relaxed);
+			result.refill_nodes += counters.refill_nodes.load(std::memory_order_relaxed);
+			result.bytes_in_free_lists += counters.carved_bytes.load(std::memory_order_relaxed);
+			result.malloc_fallbacks += counters.malloc_fallbacks.load(std::memory_order_relaxed);
+			result.malloc_bytes += counters.malloc_bytes.load(std::memory_order_relaxed);
+
+			if (!cache)
+				break;
+		}
+
+		for (size_t i = 0; i < __N_FREE_LIST; ++i)
+		{
+			result.class_size[i] = class_size(i);
+			result.bytes_in_use += (result.allocations[i] - result.deallocations[i]) * class_size(i);
+		}
+
+		// carved bytes are either in use or in a free list
+		result.bytes_in_free_lists -= result.bytes_in_use;
+		result.heap_size = heap_size;
+		return result;
+	}
+
+	template <bool threads, typename ChunkSource>
+	void __default_allocator<threads, ChunkSource>::dump_stats(std::FILE *out)
+	{
+		allocator_stats s = stats();
+
+		std::fprintf(out, "heap size:           %zu\n", s.heap_size);
+		std::fprintf(out, "bytes in use:        %zu\n", s.bytes_in_use);
+		std::fprintf(out, "bytes in free lists: %zu\n", s.bytes_in_free_lists);
+		std::fprintf(out, "refills:             %zu (%.1f nodes on average)\n", s.refills,
+		             s.refills ? static_cast<double>(s.refill_nodes) / s.refills : 0.0);
+		std::fprintf(out, "malloc fallbacks:    %zu (%zu bytes in use)\n", s.malloc_fallbacks, s.malloc_bytes);
+
+		std::fprintf(out, "%8s %14s %14s %8s\n", "size", "allocations", "deallocations", "refill");
+		for (size_t i = 0; i < __N_FREE_LIST; ++i)
+		{
+			if (s.allocations[i] || s.deallocations[i])
+				std::fprintf(out, "%8zu %14zu %14zu %8zu\n", s.class_size[i], s.allocations[i],
+				             s.deallocations[i], s.refill_size[i]);
+		}
+	}
+
+	// the counters the calling thread may write: its cache's when threads
+	// is true, the central pool's otherwise.
+	template <bool threads, typename ChunkSource>
+	inline typename __default_allocator<threads, ChunkSource>::stat_counters&
+	__default_allocator<threads, ChunkSource>::local_counters()
+	{
+		if (threads && !__LOCK_FREE)
+			return local_cache().counters;
+		return central_counters;
+	}
+
+	template <bool threads, typename ChunkSource>
+	inline void __default_allocator<threads, ChunkSource>::count(std::atomic<size_t> &counter, size_t delta)
+	{
+		// the central counters are shared by all threads in lock free mode
+		if (threads && __LOCK_FREE)
+			counter.fetch_add(delta, std::memory_order_relaxed);
+		else
+			counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	/// chunks
+	///////////////////////////////////////////////////////////////////////
+
+	// obtains a chunk from ChunkSource with at least bytes bytes to carve
+	// from, enters it into the page map and into the chunk list of its
+	// owner (or of the central pool). When ChunkSource runs out, a null
+	// pointer is returned if may_fail is true, and bad_alloc is thrown
+	// otherwise.
+	template <bool threads, typename ChunkSource>
+	typename __default_allocator<threads, ChunkSource>::chunk_header*
+	__default_allocator<threads, ChunkSource>::new_chunk(size_t bytes, thread_cache *owner, bool may_fail)
+	{
+		const size_t granule = ChunkSource::granularity;
+		const size_t header_size = round_up(sizeof(chunk_header));
+		size_t size = (bytes + header_size + granule - 1) & ~(granule - 1);
+
+		char *base = static_cast<char*>(ChunkSource::allocate(size));
+		if (!base)
+		{
+			if (may_fail)
+				return nullptr;
+			throw std::bad_alloc();
+		}
+
+		chunk_header *chunk = reinterpret_cast<chunk_header*>(base);
+		chunk->begin = base + header_size;
+		chunk->size = size - header_size;
+		chunk->owner = owner;
+		chunk->free_bytes = 0;
+
+		chunk_header *&chunk_list = owner ? owner->chunks : chunks;
+		chunk->next = chunk_list;
+		chunk_list = chunk;
+
+		register_chunk(chunk, base, size);
+		heap_size += size;
+		return chunk;
+	}
+
+	// releases the chunks in chunk_list none of whose nodes are in use,
+	// that is, all of whose bytes are either in lists or in [begin, end).
+	// The nodes of those chunks are unlinked from lists (and counts, when
+	// given, are updated), then the chunks leave the page map and are
+	// freed. Returns the number of bytes released.
+	template <bool threads, typename ChunkSource>
+	template <typename FreeList>
+	size_t __default_allocator<threads, ChunkSource>::release_free_chunks(FreeList *lists, size_t *counts, chunk_header *&chunk_list,
+	                                                         char *&begin, char *&end)
+	{
+		for (chunk_header *chunk = chunk_list; chunk; chunk = chunk->next)
+			chunk->free_bytes = 0;
+
+		if (begin != end)
+			chunk_of(begin)->free_bytes += end - begin;
+
+		for (size_t i = 0; i < __N_FREE_LIST; ++i)
+		{
+			for (free_list_node *p = lists[i]; p; p = p->next)
+				chunk_of(p)->free_bytes += class_size(i);
+		}
+
+		bool any_free = false;
+		for (chunk_header *chunk = chunk_list; chunk; chunk = chunk->next)
+			any_free = any_free || chunk->free_bytes == chunk->size;
+
+		if (!any_free)
+			return 0;
+
+		for (size_t i = 0; i < __N_FREE_LIST; ++i)
+		{
+			free_list_node *head = nullptr;
+			free_list_node **tail = &head;
+
+			for (free_list_node *p = lists[i]; p; p = p->next)
+			{
+				chunk_header *chunk = chunk_of(p);
+				if (chunk->free_bytes == chunk->size)
+				{
+					if (counts)
+						--counts[i];
+					if (__ALLOC_STATS)
+						count(local_counters().carved_bytes, -class_size(i));
+				}
+				else
+				{
+					*tail = p;
+					tail = &p->next;
+				}
+			}
+
+			*tail = nullptr;
+			lists[i] = head;
+		}
+
+		if (begin != end && chunk_of(begin)->free_bytes == chunk_of(begin)->size)
+			begin = end = nullptr;
+
+		size_t released = 0;
+		chunk_header **link = &chunk_list;
+
+		while (*link)
+		{
+			chunk_header *chunk = *link;
+			if (chunk->free_bytes != chunk->size)
+			{
+				link = &chunk->next;
+				continue;
+			}
+
+			*link = chunk->next;
+
+			char *base = reinterpret_cast<char*>(chunk);
+			size_t size = chunk->begin + chunk->size - base;
+			register_chunk(nullptr, base, size);
+			heap_size -= size;
+			released += size;
+			ChunkSource::deallocate(base, size);
+		}
+
+		return released;
+	}
+
+	// The page map is a two level radix tree from address >> __CHUNK_SHIFT
+	// to the chunk covering that address. It covers 48 bit addresses, and
+	// its second level arrays are allocated on demand. Registering a null
+	// chunk removes a released one.
+	template <bool threads, typename ChunkSource>
+	void __default_allocator<threads, ChunkSource>::register_chunk(chunk_header *chunk, char *base, size_t size)
+	{
+		const uintptr_t mask = (static_cast<uintptr_t>(1) << __PAGE_MAP_BITS) - 1;
+		uintptr_t first = reinterpret_cast<uintptr_t>(base) >> __CHUNK_SHIFT;
+		uintptr_t last = first + (size >> __CHUNK_SHIFT);
+
+		for (uintptr_t key = first; key != last; ++key)
+		{
+			std::atomic<std::atomic<chunk_header*>*> &slot = page_map[(key >> __PAGE_MAP_BITS) & mask];
+			std::atomic<chunk_header*> *leaf = slot.load(std::memory_order_acquire);
+
+			if (!leaf)
+			{
+				std::lock_guard<std::mutex> lock(page_map_lock);
+				leaf = slot.load(std::memory_order_relaxed);
+				if (!leaf)
+				{
+					leaf = static_cast<std::atomic<chunk_header*>*>(
+						std::calloc(static_cast<size_t>(1) << __PAGE_MAP_BITS, sizeof(std::atomic<chunk_header*>)));
+					if (!leaf)
+						leaf = static_cast<std::atomic<chunk_header*>*>(allocator_malloc::allocate(
+							(static_cast<size_t>(1) << __PAGE_MAP_BITS) * sizeof(std::atomic<chunk_header*>)));
+					slot.store(leaf, std::memory_order_release);
+				}
+			}
+
+			leaf[key & mask].store(chunk, std::memory_order_relaxed);
+		}
+	}
+
+	template <bool threads, typename ChunkSource>
+	inline typename __default_allocator<threads, ChunkSource>::chunk_header*
+	__default_allocator<threads, ChunkSource>::chunk_of(void *p)
+	{
+		const uintptr_t mask = (static_cast<uintptr_t>(1) << __PAGE_MAP_BITS) - 1;
+		uintptr_t key = reinterpret_cast<uintptr_t>(p) >> __CHUNK_SHIFT;
+		std::atomic<chunk_header*> *leaf = page_map[(key >> __PAGE_MAP_BITS) & mask].load(std::memory_order_acquire);
+		return leaf[key & mask].load(std::memory_order_relaxed);
+	}
+
+
+	template <bool threads, typename ChunkSource>
+	struct allocator_traits<__default_allocator<threads, ChunkSource> >
+	{
+		typedef false_type has_trivial_deallocate;
+		typedef true_type  has_batch_allocate;
+	};
+}
+
+#endif
@@ -1,6 +1,18 @@
 #ifndef TYPE_TRAITS
 #define TYPE_TRAITS
 
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5) || (defined(_MSC_VER) && _MSC_VER >= 1900)
+#define MINISTL_HAS_TYPE_TRAIT_BUILTINS 1
+#else
+#define MINISTL_HAS_TYPE_TRAIT_BUILTINS 0
+#endif
+
+#if defined(__clang__) || defined(_MSC_VER)
+#define __MINISTL_IS_TRIVIALLY_DESTRUCTIBLE(T) __is_trivially_destructible(T)
+#else
+#define __MINISTL_IS_TRIVIALLY_DESTRUCTIBLE(T) __has_trivial_destructor(T)
+#endif
+
 namespace ministl
 {
 	struct false_type
@@ -60,14 +72,51 @@ namespace ministl
 	};
 
 
+	template <bool b>
+	struct bool_type: false_type
+	{
+
+	};
+
+	template <>
+	struct bool_type<true>: true_type
+	{
+
+	};
+
+	/// type_traits
+	///
+	/// Where the compiler can tell, the defaults come from its type trait
+	/// built-ins, so a plain struct such as
+	///
+	///     struct Point { int x, y; };
+	///
+	/// takes the memmove paths of uninitialized.h without further ado. A
+	/// type is a POD type here when it is trivial, i.e. trivially copyable
+	/// and trivially default constructible. Without the built-ins every
+	/// type defaults to false_type. Either way an explicit specialization
+	/// of type_traits overrides the defaults.
+	///
+	/// Value initialization of a POD type is done with memset to zero, so
+	/// a trivial type that holds a pointer to a data member (null is -1 on
+	/// the Itanium ABI, not 0) has to be specialized with is_POD_type
+	/// false_type.
 	template <typename T>
 	struct type_traits
 	{
+#if MINISTL_HAS_TYPE_TRAIT_BUILTINS
+		typedef bool_type<__is_trivially_constructible(T)>                  is_trivally_default_constructible;
+		typedef bool_type<__is_trivially_constructible(T, const T&)>        is_trivally_copy_constructible;
+		typedef bool_type<__is_trivially_assignable(T&, const T&)>          is_trivally_assigmentable;
+		typedef bool_type<__MINISTL_IS_TRIVIALLY_DESTRUCTIBLE(T)>           is_trivially_destructible;
+		typedef bool_type<__is_trivial(T)>                                  is_POD_type;
+#else
 		typedef false_type is_trivally_default_constructible;
 		typedef false_type is_trivally_copy_constructible;
 		typedef false_type is_trivally_assigmentable;
 		typedef false_type is_trivially_destructible;
 		typedef false_type is_POD_type;
+#endif
 	};
 
 	template <>
@@ -199,6 +248,47 @@ namespace ministl
 		typedef true_type is_trivially_destructible;
 		typedef true_type is_POD_type;
 	};
+
+	/// is_trivially_relocatable
+	///
+	/// A type is trivially relocatable when moving an object to new storage
+	/// and destroying the old one is the same as copying its bytes, as for
+	/// most handles that own a pointer. uninitialized_relocate then uses
+	/// memcpy. POD types are, and others opt in with
+	///
+	///     template <>
+	///     struct is_trivially_relocatable<my_handle>: true_type
+	///     {
+	///
+	///     };
+	///
+	/// A type that keeps a pointer into itself, or is registered somewhere
+	/// by its address, must not.
+	template <typename T>
+	struct is_trivially_relocatable: type_traits<T>::is_POD_type
+	{
+
+	};
+
+	/// allocator_traits
+	///
+	/// Tells the containers what an allocator can do beyond allocate and
+	/// deallocate. An allocator whose deallocate does nothing (such as
+	/// arena_allocator) specializes has_trivial_deallocate as true_type,
+	/// and the containers then skip handing their nodes back one by one.
+	/// An allocator with has_batch_allocate as true_type has a member
+	///
+	///     void *allocate_batch(size_t n, size_t count);
+	///
+	/// returning count blocks of n bytes, each holding in its first word a
+	/// void* to the next one, the last one a null pointer. Bulk inserts
+	/// then take all their nodes with one call.
+	template <typename Allocator>
+	struct allocator_traits
+	{
+		typedef false_type has_trivial_deallocate;
+		typedef false_type has_batch_allocate;
+	};
 }
 
 #endif
\ No newline at end of file
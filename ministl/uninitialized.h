@@ -2,8 +2,13 @@
 #define UNINITIALIZED_H
 
 #include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
 #include "algorithm.h"
 #include "construct.h"
+#include "stream_store.h"
+#include "type_traits.h"
 #include "uninitialized.h"
 
 namespace ministl
@@ -46,6 +51,24 @@ namespace ministl
 		return std::copy(first, last, d_first);
 	}
 
+	// large ranges are copied with streaming stores, see stream_store.h.
+	template <typename T>
+	T *uninitialized_copy_impl(const T *first, const T *last, T *d_first, true_type)
+	{
+		size_t bytes = sizeof(T) * (last - first);
+		if (!use_stream_store(bytes))
+			return std::copy(first, last, d_first);
+
+		stream_copy(d_first, first, bytes);
+		return d_first + (last - first);
+	}
+
+	template <typename T>
+	T *uninitialized_copy_impl(T *first, T *last, T *d_first, true_type)
+	{
+		return uninitialized_copy_impl(static_cast<const T*>(first), static_cast<const T*>(last), d_first, true_type());
+	}
+
 	template <typename InputIterator, typename ForwardIterator>
 	ForwardIterator uninitialized_copy_impl(InputIterator first, InputIterator last,
 	                                        ForwardIterator d_first,
@@ -113,6 +136,290 @@ namespace ministl
 		typedef typename iterator_traits<ForwardIterator>::value_type value_type;
 		uninitialized_fill_impl(first, last, value, typename type_traits<value_type>::is_POD_type());
 	}
+
+	template <typename InputIterator, typename ForwardIterator>
+	ForwardIterator uninitialized_move_impl(InputIterator first, InputIterator last,
+	                                        ForwardIterator d_first,
+	                                        true_type)
+	{
+		return std::copy(first, last, d_first);
+	}
+
+	template <typename T>
+	T *uninitialized_move_impl(T *first, T *last, T *d_first, true_type)
+	{
+		size_t bytes = sizeof(T) * (last - first);
+		if (use_stream_store(bytes))
+			stream_copy(d_first, first, bytes);
+		else if (bytes > 0)
+			std::memmove(static_cast<void*>(d_first), static_cast<const void*>(first), bytes);
+		return d_first + (last - first);
+	}
+
+	template <typename InputIterator, typename ForwardIterator>
+	ForwardIterator uninitialized_move_impl(InputIterator first, InputIterator last,
+	                                        ForwardIterator d_first,
+	                                        false_type)
+	{
+		typedef typename iterator_traits<ForwardIterator>::value_type value_type;
+		ForwardIterator current = d_first;
+		try
+		{
+			for (; first != last; ++first, ++current)
+				::new(static_cast<void*>(&*current)) value_type(std::move(*first));
+			return current;
+		}
+		catch (...)
+		{
+			destroy(d_first, current);
+			throw;
+		}
+	}
+
+	template <typename InputIterator, typename ForwardIterator>
+	ForwardIterator uninitialized_move(InputIterator first, InputIterator last,
+	                                   ForwardIterator d_first)
+	{
+		typedef typename iterator_traits<ForwardIterator>::value_type value_type;
+		return uninitialized_move_impl(first, last, d_first, typename type_traits<value_type>::is_POD_type());
+	}
+
+	template <typename InputIterator, typename Size, typename ForwardIterator>
+	ForwardIterator uninitialized_move_n_impl(InputIterator first, Size size,
+	                                          ForwardIterator d_first,
+	                                          true_type)
+	{
+		for (; size > 0; --size, ++first, ++d_first)
+			*d_first = *first;
+		return d_first;
+	}
+
+	template <typename T, typename Size>
+	T *uninitialized_move_n_impl(T *first, Size size, T *d_first, true_type)
+	{
+		return uninitialized_move_impl(first, first + size, d_first, true_type());
+	}
+
+	template <typename InputIterator, typename Size, typename ForwardIterator>
+	ForwardIterator uninitialized_move_n_impl(InputIterator first, Size size,
+	                                          ForwardIterator d_first,
+	                                          false_type)
+	{
+		typedef typename iterator_traits<ForwardIterator>::value_type value_type;
+		ForwardIterator current = d_first;
+		try
+		{
+			for (; size > 0; --size, ++first, ++current)
+				::new(static_cast<void*>(&*current)) value_type(std::move(*first));
+			return current;
+		}
+		catch (...)
+		{
+			destroy(d_first, current);
+			throw;
+		}
+	}
+
+	template <typename InputIterator, typename Size, typename ForwardIterator>
+	ForwardIterator uninitialized_move_n(InputIterator first, Size size, ForwardIterator d_first)
+	{
+		typedef typename iterator_traits<ForwardIterator>::value_type value_type;
+		return uninitialized_move_n_impl(first, size, d_first, typename type_traits<value_type>::is_POD_type());
+	}
+
+	// a trivially default constructible object is left as the memory was.
+	template <typename ForwardIterator>
+	void uninitialized_default_construct_impl(ForwardIterator, ForwardIterator, true_type)
+	{
+		// empty
+	}
+
+	template <typename ForwardIterator>
+	void uninitialized_default_construct_impl(ForwardIterator first, ForwardIterator last, false_type)
+	{
+		typedef typename iterator_traits<ForwardIterator>::value_type value_type;
+		ForwardIterator current = first;
+		try
+		{
+			for (; current != last; ++current)
+				::new(static_cast<void*>(&*current)) value_type;
+		}
+		catch (...)
+		{
+			destroy(first, current);
+			throw;
+		}
+	}
+
+	template <typename ForwardIterator>
+	void uninitialized_default_construct(ForwardIterator first, ForwardIterator last)
+	{
+		typedef typename iterator_traits<ForwardIterator>::value_type value_type;
+		uninitialized_default_construct_impl(first, last,
+			typename type_traits<value_type>::is_trivally_default_constructible());
+	}
+
+	template <typename ForwardIterator, typename Size>
+	ForwardIterator uninitialized_default_construct_n(ForwardIterator first, Size size)
+	{
+		ForwardIterator last = first;
+		ministl::advance(last, size);
+		uninitialized_default_construct(first, last);
+		return last;
+	}
+
+	template <typename ForwardIterator>
+	void uninitialized_value_construct_impl(ForwardIterator first, ForwardIterator last, true_type)
+	{
+		typedef typename iterator_traits<ForwardIterator>::value_type value_type;
+		fill(first, last, value_type());
+	}
+
+	// a value initialized POD type is taken to be all bits zero. That holds
+	// for arithmetic types and pointers, but not for pointers to data
+	// members, whose null value is -1 on the Itanium ABI: arrays of types
+	// that hold one need an explicit type_traits specialization with
+	// is_POD_type false_type.
+	template <typename T>
+	void uninitialized_value_construct_impl(T *first, T *last, true_type)
+	{
+		if (first != last)
+			std::memset(static_cast<void*>(first), 0, sizeof(T) * (last - first));
+	}
+
+	template <typename ForwardIterator>
+	void uninitialized_value_construct_impl(ForwardIterator first, ForwardIterator last, false_type)
+	{
+		typedef typename iterator_traits<ForwardIterator>::value_type value_type;
+		ForwardIterator current = first;
+		try
+		{
+			for (; current != last; ++current)
+				::new(static_cast<void*>(&*current)) value_type();
+		}
+		catch (...)
+		{
+			destroy(first, current);
+			throw;
+		}
+	}
+
+	template <typename ForwardIterator>
+	void uninitialized_value_construct(ForwardIterator first, ForwardIterator last)
+	{
+		typedef typename iterator_traits<ForwardIterator>::value_type value_type;
+		uninitialized_value_construct_impl(first, last, typename type_traits<value_type>::is_POD_type());
+	}
+
+	template <typename ForwardIterator, typename Size>
+	ForwardIterator uninitialized_value_construct_n(ForwardIterator first, Size size)
+	{
+		ForwardIterator last = first;
+		ministl::advance(last, size);
+		uninitialized_value_construct(first, last);
+		return last;
+	}
+
+	template <typename ForwardIterator1, typename ForwardIterator2>
+	ForwardIterator2 uninitialized_relocate_impl(ForwardIterator1 first, ForwardIterator1 last,
+	                                             ForwardIterator2 d_first,
+	                                             true_type)
+	{
+		typedef typename iterator_traits<ForwardIterator2>::value_type value_type;
+		for (; first != last; ++first, ++d_first)
+			std::memcpy(static_cast<void*>(&*d_first), static_cast<const void*>(&*first), sizeof(value_type));
+		return d_first;
+	}
+
+	template <typename T>
+	T *uninitialized_relocate_impl(T *first, T *last, T *d_first, true_type)
+	{
+		if (first != last)
+			std::memcpy(static_cast<void*>(d_first), static_cast<const void*>(first), sizeof(T) * (last - first));
+		return d_first + (last - first);
+	}
+
+	// the sources are only destroyed once every element is moved, so when a
+	// move constructor throws they are all still there.
+	template <typename ForwardIterator1, typename ForwardIterator2>
+	ForwardIterator2 uninitialized_relocate_impl(ForwardIterator1 first, ForwardIterator1 last,
+	                                             ForwardIterator2 d_first,
+	                                             false_type)
+	{
+		typedef typename iterator_traits<ForwardIterator2>::value_type value_type;
+		ForwardIterator2 current = d_first;
+		try
+		{
+			for (ForwardIterator1 it = first; it != last; ++it, ++current)
+				::new(static_cast<void*>(&*current)) value_type(std::move(*it));
+		}
+		catch (...)
+		{
+			destroy(d_first, current);
+			throw;
+		}
+		destroy(first, last);
+		return current;
+	}
+
+	// moves [first, last) into the uninitialized memory at d_first and
+	// destroys the sources, in one memcpy for trivially relocatable types.
+	// The ranges must not overlap.
+	template <typename ForwardIterator1, typename ForwardIterator2>
+	ForwardIterator2 uninitialized_relocate(ForwardIterator1 first, ForwardIterator1 last,
+	                                        ForwardIterator2 d_first)
+	{
+		typedef typename iterator_traits<ForwardIterator2>::value_type value_type;
+		return uninitialized_relocate_impl(first, last, d_first, is_trivially_relocatable<value_type>());
+	}
+
+	template <typename ForwardIterator1, typename Size, typename ForwardIterator2>
+	ForwardIterator2 uninitialized_relocate_n_impl(ForwardIterator1 first, Size size,
+	                                               ForwardIterator2 d_first,
+	                                               true_type)
+	{
+		typedef typename iterator_traits<ForwardIterator2>::value_type value_type;
+		for (; size > 0; --size, ++first, ++d_first)
+			std::memcpy(static_cast<void*>(&*d_first), static_cast<const void*>(&*first), sizeof(value_type));
+		return d_first;
+	}
+
+	template <typename T, typename Size>
+	T *uninitialized_relocate_n_impl(T *first, Size size, T *d_first, true_type)
+	{
+		if (size > 0)
+			std::memcpy(static_cast<void*>(d_first), static_cast<const void*>(first), sizeof(T) * size);
+		return d_first + size;
+	}
+
+	template <typename ForwardIterator1, typename Size, typename ForwardIterator2>
+	ForwardIterator2 uninitialized_relocate_n_impl(ForwardIterator1 first, Size size,
+	                                               ForwardIterator2 d_first,
+	                                               false_type)
+	{
+		typedef typename iterator_traits<ForwardIterator2>::value_type value_type;
+		ForwardIterator1 it = first;
+		ForwardIterator2 current = d_first;
+		try
+		{
+			for (; size > 0; --size, ++it, ++current)
+				::new(static_cast<void*>(&*current)) value_type(std::move(*it));
+		}
+		catch (...)
+		{
+			destroy(d_first, current);
+			throw;
+		}
+		destroy(first, it);
+		return current;
+	}
+
+	template <typename ForwardIterator1, typename Size, typename ForwardIterator2>
+	ForwardIterator2 uninitialized_relocate_n(ForwardIterator1 first, Size size, ForwardIterator2 d_first)
+	{
+		typedef typename iterator_traits<ForwardIterator2>::value_type value_type;
+		return uninitialized_relocate_n_impl(first, size, d_first, is_trivially_relocatable<value_type>());
+	}
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,1183 @@
+#ifndef VECTOR_H
+#define VECTOR_H
+
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "allocator.h"
+#include "iterator.h"
+#include "type_traits.h"
+#include "uninitialized.h"
+
+namespace ministl
+{
+	/// growth_factor
+	///
+	/// The default growth policy of vector. A growth policy is a class with
+	///
+	///     static size_t next_capacity(size_t capacity, size_t required);
+	///
+	/// returning the capacity to reallocate to when a vector of the given
+	/// capacity needs room for required elements; it must be at least
+	/// required. growth_factor multiplies the capacity by Num / Den. A
+	/// factor below 2 (1.5 by default) lets the pool reuse the blocks a
+	/// growing vector gave back; 2 reallocates less often.
+	template <size_t Num, size_t Den>
+	struct growth_factor
+	{
+		static size_t next_capacity(size_t capacity, size_t required);
+	};
+
+	template <size_t Num, size_t Den>
+	inline size_t growth_factor<Num, Den>::next_capacity(size_t capacity, size_t required)
+	{
+		size_t grown = capacity * Num / Den;
+		if (grown <= capacity)
+			grown = capacity + 1;
+		return grown < required ? required : grown;
+	}
+
+
+	template <typename T, typename Allocator>
+	class VectorBase
+	{
+	public:
+		typedef ptrdiff_t difference_type;
+		typedef size_t    size_type;
+		typedef Allocator allocator_type;
+
+		const allocator_type &get_allocator()const;
+		allocator_type       &get_allocator();
+		void                  set_allocator(const allocator_type &alloc);
+
+	protected:
+		VectorBase();
+		VectorBase(const allocator_type &alloc);
+		~VectorBase();
+
+		T   *DoAllocate(size_type n);
+		void DoFree(T *p, size_type n);
+
+	protected:
+		T              *mpBegin;
+		T              *mpEnd;
+		T              *mpCapacity;
+		allocator_type  mAllocator;
+	};
+
+
+	/// vector
+	///
+	/// A contiguous dynamic array. Its storage comes from Allocator like the
+	/// nodes of list, so small vectors are served from the pools of
+	/// sub_alloc.h. When it is full, the new capacity comes from
+	/// GrowthPolicy, see growth_factor.
+	///
+	/// Reallocation relocates the elements: a trivially relocatable T (see
+	/// type_traits.h) is moved with one memcpy, anything else is move
+	/// constructed into the new storage before the old elements are
+	/// destroyed. resize_default_init grows the vector without initializing
+	/// the new elements of a trivially default constructible T, for buffers
+	/// that are about to be overwritten anyway.
+	template <typename T, typename Allocator = alloc, typename GrowthPolicy = growth_factor<3, 2> >
+	class vector: public VectorBase<T, Allocator>
+	{
+		typedef VectorBase<T, Allocator>                  base_type;
+		typedef vector<T, Allocator, GrowthPolicy>        this_type;
+
+	public:
+		typedef T                                         value_type;
+		typedef T*                                        pointer;
+		typedef const T*                                  const_pointer;
+		typedef T&                                        reference;
+		typedef const T&                                  const_reference;
+		typedef T*                                        iterator;
+		typedef const T*                                  const_iterator;
+		typedef ministl::reverse_iterator<iterator>       reverse_iterator;
+		typedef ministl::reverse_iterator<const_iterator> const_reverse_iterator;
+		typedef typename base_type::size_type             size_type;
+		typedef typename base_type::difference_type       difference_type;
+		typedef typename base_type::allocator_type        allocator_type;
+		typedef GrowthPolicy                              growth_policy;
+
+		using base_type::mpBegin;
+		using base_type::mpEnd;
+		using base_type::mpCapacity;
+		using base_type::mAllocator;
+		using base_type::DoAllocate;
+		using base_type::DoFree;
+		using base_type::get_allocator;
+
+	public:
+		vector();
+		vector(const allocator_type &alloc);
+		explicit vector(size_type n, const allocator_type &alloc = Allocator());
+		vector(size_type n, const value_type &value, const allocator_type &alloc = Allocator());
+		vector(const this_type &other);
+		vector(this_type &&other);
+		vector(std::initializer_list<T> ilist, const allocator_type &alloc = Allocator());
+
+		template <typename InputIterator>
+		vector(InputIterator first, InputIterator last);
+
+		~vector();
+
+		this_type &operator=(const this_type &other);
+		this_type &operator=(this_type &&other);
+		this_type &operator=(std::initializer_list<T> ilist);
+
+		void assign(size_type count, const T &value);
+
+		template <typename InputIterator>
+		void assign(InputIterator first, InputIterator last);
+
+		void assign(std::initializer_list<T> ilist);
+
+		reference       at(size_type i);
+		const_reference at(size_type i)const;
+		reference       operator[](size_type i);
+		const_reference operator[](size_type i)const;
+
+		reference       front();
+		const_reference front()const;
+		reference       back();
+		const_reference back()const;
+
+		T*       data();
+		const T* data()const;
+
+		iterator               begin();
+		const_iterator         begin()const;
+		const_iterator         cbegin()const;
+		iterator               end();
+		const_iterator         end()const;
+		const_iterator         cend()const;
+		reverse_iterator       rbegin();
+		const_reverse_iterator rbegin()const;
+		const_reverse_iterator crbegin()const;
+		reverse_iterator       rend();
+		const_reverse_iterator rend()const;
+		const_reverse_iterator crend()const;
+
+		bool      empty()const;
+		size_type size()const;
+		size_type capacity()const;
+		void      reserve(size_type n);
+		void      shrink_to_fit();
+
+		void     clear();
+		iterator insert(const_iterator pos, const T &value);
+		iterator insert(const_iterator pos, T &&value);
+		iterator insert(const_iterator pos, size_type n, const T &value);
+		template <typename InputIterator>
+		iterator insert(const_iterator pos, InputIterator first, InputIterator last);
+		iterator insert(const_iterator pos, std::initializer_list<T> ilist);
+		template <typename...Args>
+		iterator emplace(const_iterator pos, Args&&...args);
+		iterator erase(const_iterator pos);
+		iterator erase(const_iterator first, const_iterator last);
+		void     push_back(const T &value);
+		void     push_back(T &&value);
+		template <typename...Args>
+		reference emplace_back(Args&&...args);
+		void     pop_back();
+		void     resize(size_type n);
+		void     resize(size_type n, const T &value);
+		void     resize_default_init(size_type n);
+		void     swap(this_type &other);
+
+	protected:
+		size_type GrowCapacity(size_type required)const;
+
+		void Reallocate(size_type n);
+
+		void RelocateAround(T *pNew, size_type index, size_type gap);
+		void RelocateAround(T *pNew, size_type index, size_type gap, true_type);
+		void RelocateAround(T *pNew, size_type index, size_type gap, false_type);
+
+		static T *MoveIfNoexcept(T *first, T *last, T *pDest);
+		static T *MoveIfNoexcept(T *first, T *last, T *pDest, true_type);
+		static T *MoveIfNoexcept(T *first, T *last, T *pDest, false_type);
+
+		void FreeStorage();
+
+		template <typename...Args>
+		void ReallocEmplace(size_type index, Args&&...args);
+
+		void InsertValues(size_type index, size_type n, const T &value);
+
+		template <typename Integer>
+		void Insert(size_type index, Integer n, Integer value, true_type);
+
+		template <typename InputIterator>
+		void Insert(size_type index, InputIterator first, InputIterator last, false_type);
+
+		template <typename InputIterator>
+		void InsertRange(size_type index, InputIterator first, InputIterator last, input_iterator_tag);
+
+		template <typename ForwardIterator>
+		void InsertRange(size_type index, ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+	};
+
+
+	////////////////////////////////////////
+	// VectorBase
+	////////////////////////////////////////
+
+	template <typename T, typename Allocator>
+	VectorBase<T, Allocator>::VectorBase()
+		: mpBegin(nullptr),
+		  mpEnd(nullptr),
+		  mpCapacity(nullptr),
+		  mAllocator(Allocator())
+	{
+		// empty
+	}
+
+
+	template <typename T, typename Allocator>
+	VectorBase<T, Allocator>::VectorBase(const allocator_type &alloc)
+		: mpBegin(nullptr),
+		  mpEnd(nullptr),
+		  mpCapacity(nullptr),
+		  mAllocator(alloc)
+	{
+		// empty
+	}
+
+
+	template <typename T, typename Allocator>
+	VectorBase<T, Allocator>::~VectorBase()
+	{
+		DoFree(mpBegin, mpCapacity - mpBegin);
+	}
+
+
+	template <typename T, typename Allocator>
+	const typename VectorBase<T, Allocator>::allocator_type&
+	VectorBase<T, Allocator>::get_allocator()const
+	{
+		return mAllocator;
+	}
+
+
+	template <typename T, typename Allocator>
+	typename VectorBase<T, Allocator>::allocator_type&
+	VectorBase<T, Allocator>::get_allocator()
+	{
+		return mAllocator;
+	}
+
+
+	template <typename T, typename Allocator>
+	void VectorBase<T, Allocator>::set_allocator(const allocator_type &alloc)
+	{
+		mAllocator = alloc;
+	}
+
+
+	template <typename T, typename Allocator>
+	T *VectorBase<T, Allocator>::DoAllocate(size_type n)
+	{
+		if (n == 0)
+			return nullptr;
+		return (T*)allocate_memory(mAllocator, n * sizeof(T));
+	}
+
+
+	template <typename T, typename Allocator>
+	void VectorBase<T, Allocator>::DoFree(T *p, size_type n)
+	{
+		if (p)
+			MINISTLFree(mAllocator, p, n * sizeof(T));
+	}
+
+
+	////////////////////////////////////////
+	// vector
+	////////////////////////////////////////
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	vector<T, Allocator, GrowthPolicy>::vector()
+		: base_type()
+	{
+		// empty
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	vector<T, Allocator, GrowthPolicy>::vector(const allocator_type &alloc)
+		: base_type(alloc)
+	{
+		// empty
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	vector<T, Allocator, GrowthPolicy>::vector(size_type n, const allocator_type &alloc)
+		: base_type(alloc)
+	{
+		mpBegin = DoAllocate(n);
+		mpEnd = mpBegin;
+		mpCapacity = mpBegin + n;
+		ministl::uninitialized_value_construct(mpBegin, mpBegin + n);
+		mpEnd = mpBegin + n;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	vector<T, Allocator, GrowthPolicy>::vector(size_type n, const value_type &value, const allocator_type &alloc)
+		: base_type(alloc)
+	{
+		mpBegin = DoAllocate(n);
+		mpEnd = mpBegin;
+		mpCapacity = mpBegin + n;
+		mpEnd = ministl::uninitialized_fill_n(mpBegin, n, value);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	vector<T, Allocator, GrowthPolicy>::vector(const this_type &other)
+		: base_type(other.mAllocator)
+	{
+		size_type n = other.size();
+		mpBegin = DoAllocate(n);
+		mpEnd = mpBegin;
+		mpCapacity = mpBegin + n;
+		mpEnd = ministl::uninitialized_copy(other.mpBegin, other.mpEnd, mpBegin);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	vector<T, Allocator, GrowthPolicy>::vector(this_type &&other)
+		: base_type(other.mAllocator)
+	{
+		swap(other);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	vector<T, Allocator, GrowthPolicy>::vector(std::initializer_list<T> ilist, const allocator_type &alloc)
+		: base_type(alloc)
+	{
+		InsertRange(0, ilist.begin(), ilist.end(), forward_iterator_tag());
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	template <typename InputIterator>
+	vector<T, Allocator, GrowthPolicy>::vector(InputIterator first, InputIterator last)
+		: base_type()
+	{
+		Insert(0, first, last, is_integral<InputIterator>());
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	vector<T, Allocator, GrowthPolicy>::~vector()
+	{
+		ministl::destroy(mpBegin, mpEnd);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	typename vector<T, Allocator, GrowthPolicy>::this_type&
+	vector<T, Allocator, GrowthPolicy>::operator=(const this_type &other)
+	{
+		if (this != &other)
+			assign(other.mpBegin, other.mpEnd);
+		return *this;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	typename vector<T, Allocator, GrowthPolicy>::this_type&
+	vector<T, Allocator, GrowthPolicy>::operator=(this_type &&other)
+	{
+		if (this != &other)
+		{
+			this_type temp(mAllocator);
+			swap(other);
+			other.swap(temp);
+		}
+		return *this;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	typename vector<T, Allocator, GrowthPolicy>::this_type&
+	vector<T, Allocator, GrowthPolicy>::operator=(std::initializer_list<T> ilist)
+	{
+		assign(ilist.begin(), ilist.end());
+		return *this;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::assign(size_type count, const T &value)
+	{
+		if (count > capacity())
+		{
+			this_type temp(count, value, mAllocator);
+			swap(temp);
+		}
+		else if (count > size())
+		{
+			std::fill(mpBegin, mpEnd, value);
+			mpEnd = ministl::uninitialized_fill_n(mpEnd, count - size(), value);
+		}
+		else
+		{
+			std::fill_n(mpBegin, count, value);
+			erase(mpBegin + count, mpEnd);
+		}
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	template <typename InputIterator>
+	void vector<T, Allocator, GrowthPolicy>::assign(InputIterator first, InputIterator last)
+	{
+		clear();
+		Insert(0, first, last, is_integral<InputIterator>());
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::assign(std::initializer_list<T> ilist)
+	{
+		assign(ilist.begin(), ilist.end());
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::reference
+	vector<T, Allocator, GrowthPolicy>::at(size_type i)
+	{
+		if (i >= size())
+			throw std::out_of_range("vector::at(size_type i) out of range");
+		return mpBegin[i];
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_reference
+	vector<T, Allocator, GrowthPolicy>::at(size_type i)const
+	{
+		if (i >= size())
+			throw std::out_of_range("vector::at(size_type i) out of range");
+		return mpBegin[i];
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::reference
+	vector<T, Allocator, GrowthPolicy>::operator[](size_type i)
+	{
+		return mpBegin[i];
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_reference
+	vector<T, Allocator, GrowthPolicy>::operator[](size_type i)const
+	{
+		return mpBegin[i];
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::reference
+	vector<T, Allocator, GrowthPolicy>::front()
+	{
+		return *mpBegin;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_reference
+	vector<T, Allocator, GrowthPolicy>::front()const
+	{
+		return *mpBegin;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::reference
+	vector<T, Allocator, GrowthPolicy>::back()
+	{
+		return mpEnd[-1];
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_reference
+	vector<T, Allocator, GrowthPolicy>::back()const
+	{
+		return mpEnd[-1];
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline T *vector<T, Allocator, GrowthPolicy>::data()
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline const T *vector<T, Allocator, GrowthPolicy>::data()const
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::iterator
+	vector<T, Allocator, GrowthPolicy>::begin()
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_iterator
+	vector<T, Allocator, GrowthPolicy>::begin()const
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_iterator
+	vector<T, Allocator, GrowthPolicy>::cbegin()const
+	{
+		return mpBegin;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::iterator
+	vector<T, Allocator, GrowthPolicy>::end()
+	{
+		return mpEnd;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_iterator
+	vector<T, Allocator, GrowthPolicy>::end()const
+	{
+		return mpEnd;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_iterator
+	vector<T, Allocator, GrowthPolicy>::cend()const
+	{
+		return mpEnd;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::reverse_iterator
+	vector<T, Allocator, GrowthPolicy>::rbegin()
+	{
+		return reverse_iterator(mpEnd);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_reverse_iterator
+	vector<T, Allocator, GrowthPolicy>::rbegin()const
+	{
+		return const_reverse_iterator(mpEnd);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_reverse_iterator
+	vector<T, Allocator, GrowthPolicy>::crbegin()const
+	{
+		return const_reverse_iterator(mpEnd);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::reverse_iterator
+	vector<T, Allocator, GrowthPolicy>::rend()
+	{
+		return reverse_iterator(mpBegin);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_reverse_iterator
+	vector<T, Allocator, GrowthPolicy>::rend()const
+	{
+		return const_reverse_iterator(mpBegin);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::const_reverse_iterator
+	vector<T, Allocator, GrowthPolicy>::crend()const
+	{
+		return const_reverse_iterator(mpBegin);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline bool vector<T, Allocator, GrowthPolicy>::empty()const
+	{
+		return mpBegin == mpEnd;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::size_type
+	vector<T, Allocator, GrowthPolicy>::size()const
+	{
+		return mpEnd - mpBegin;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::size_type
+	vector<T, Allocator, GrowthPolicy>::capacity()const
+	{
+		return mpCapacity - mpBegin;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::reserve(size_type n)
+	{
+		if (n > capacity())
+			Reallocate(n);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::shrink_to_fit()
+	{
+		if (mpCapacity != mpEnd)
+			Reallocate(size());
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::clear()
+	{
+		ministl::destroy(mpBegin, mpEnd);
+		mpEnd = mpBegin;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	typename vector<T, Allocator, GrowthPolicy>::iterator
+	vector<T, Allocator, GrowthPolicy>::insert(const_iterator pos, const T &value)
+	{
+		return emplace(pos, value);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	typename vector<T, Allocator, GrowthPolicy>::iterator
+	vector<T, Allocator, GrowthPolicy>::insert(const_iterator pos, T &&value)
+	{
+		return emplace(pos, std::move(value));
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	typename vector<T, Allocator, GrowthPolicy>::iterator
+	vector<T, Allocator, GrowthPolicy>::insert(const_iterator pos, size_type n, const T &value)
+	{
+		size_type index = pos - mpBegin;
+		InsertValues(index, n, value);
+		return mpBegin + index;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	template <typename InputIterator>
+	typename vector<T, Allocator, GrowthPolicy>::iterator
+	vector<T, Allocator, GrowthPolicy>::insert(const_iterator pos, InputIterator first, InputIterator last)
+	{
+		size_type index = pos - mpBegin;
+		Insert(index, first, last, is_integral<InputIterator>());
+		return mpBegin + index;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	typename vector<T, Allocator, GrowthPolicy>::iterator
+	vector<T, Allocator, GrowthPolicy>::insert(const_iterator pos, std::initializer_list<T> ilist)
+	{
+		return insert(pos, ilist.begin(), ilist.end());
+	}
+
+
+	// the new element is constructed before anything is moved, so args may
+	// refer to elements of the vector itself.
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	template <typename...Args>
+	typename vector<T, Allocator, GrowthPolicy>::iterator
+	vector<T, Allocator, GrowthPolicy>::emplace(const_iterator pos, Args&&...args)
+	{
+		size_type index = pos - mpBegin;
+
+		if (mpEnd == mpCapacity)
+			ReallocEmplace(index, std::forward<Args>(args)...);
+		else if (mpBegin + index == mpEnd)
+		{
+			::new(static_cast<void*>(mpEnd)) value_type(std::forward<Args>(args)...);
+			++mpEnd;
+		}
+		else
+		{
+			value_type temp(std::forward<Args>(args)...);
+			::new(static_cast<void*>(mpEnd)) value_type(std::move(mpEnd[-1]));
+			++mpEnd;
+			std::move_backward(mpBegin + index, mpEnd - 2, mpEnd - 1);
+			mpBegin[index] = std::move(temp);
+		}
+		return mpBegin + index;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	typename vector<T, Allocator, GrowthPolicy>::iterator
+	vector<T, Allocator, GrowthPolicy>::erase(const_iterator pos)
+	{
+		iterator it = mpBegin + (pos - mpBegin);
+		std::move(it + 1, mpEnd, it);
+		--mpEnd;
+		mpEnd->~value_type();
+		return it;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	typename vector<T, Allocator, GrowthPolicy>::iterator
+	vector<T, Allocator, GrowthPolicy>::erase(const_iterator first, const_iterator last)
+	{
+		iterator it = mpBegin + (first - mpBegin);
+		if (first != last)
+		{
+			iterator pNewEnd = std::move(mpBegin + (last - mpBegin), mpEnd, it);
+			ministl::destroy(pNewEnd, mpEnd);
+			mpEnd = pNewEnd;
+		}
+		return it;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline void vector<T, Allocator, GrowthPolicy>::push_back(const T &value)
+	{
+		emplace_back(value);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline void vector<T, Allocator, GrowthPolicy>::push_back(T &&value)
+	{
+		emplace_back(std::move(value));
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	template <typename...Args>
+	inline typename vector<T, Allocator, GrowthPolicy>::reference
+	vector<T, Allocator, GrowthPolicy>::emplace_back(Args&&...args)
+	{
+		if (mpEnd != mpCapacity)
+		{
+			::new(static_cast<void*>(mpEnd)) value_type(std::forward<Args>(args)...);
+			++mpEnd;
+		}
+		else
+			ReallocEmplace(size(), std::forward<Args>(args)...);
+		return mpEnd[-1];
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline void vector<T, Allocator, GrowthPolicy>::pop_back()
+	{
+		--mpEnd;
+		mpEnd->~value_type();
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::resize(size_type n)
+	{
+		if (n > size())
+		{
+			if (n > capacity())
+				Reallocate(GrowCapacity(n));
+			ministl::uninitialized_value_construct(mpEnd, mpBegin + n);
+			mpEnd = mpBegin + n;
+		}
+		else
+			erase(mpBegin + n, mpEnd);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::resize(size_type n, const T &value)
+	{
+		if (n > size())
+			InsertValues(size(), n - size(), value);
+		else
+			erase(mpBegin + n, mpEnd);
+	}
+
+
+	// like resize, but the new elements are default initialized: for a
+	// trivially default constructible T they are left as the memory was.
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::resize_default_init(size_type n)
+	{
+		if (n > size())
+		{
+			if (n > capacity())
+				Reallocate(GrowCapacity(n));
+			ministl::uninitialized_default_construct(mpEnd, mpBegin + n);
+			mpEnd = mpBegin + n;
+		}
+		else
+			erase(mpBegin + n, mpEnd);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::swap(this_type &other)
+	{
+		std::swap(mpBegin, other.mpBegin);
+		std::swap(mpEnd, other.mpEnd);
+		std::swap(mpCapacity, other.mpCapacity);
+		std::swap(mAllocator, other.mAllocator);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::size_type
+	vector<T, Allocator, GrowthPolicy>::GrowCapacity(size_type required)const
+	{
+		return GrowthPolicy::next_capacity(capacity(), required);
+	}
+
+
+	// moves the elements to new storage of capacity n, n >= size().
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::Reallocate(size_type n)
+	{
+		T *pNew = DoAllocate(n);
+		size_type count = size();
+		try
+		{
+			RelocateAround(pNew, count, 0);
+		}
+		catch (...)
+		{
+			DoFree(pNew, n);
+			throw;
+		}
+		FreeStorage();
+		mpBegin = pNew;
+		mpEnd = pNew + count;
+		mpCapacity = pNew + n;
+	}
+
+
+	// relocates the elements before index to pNew, and the rest to
+	// pNew + index + gap, leaving a gap of uninitialized elements. The old
+	// elements are left destroyed, but not freed. When this throws nothing
+	// is left constructed at pNew, and the old elements are unchanged
+	// unless T has a move constructor that may throw and no copy
+	// constructor, in which case some of them may have been moved from.
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline void vector<T, Allocator, GrowthPolicy>::RelocateAround(T *pNew, size_type index, size_type gap)
+	{
+		RelocateAround(pNew, index, gap, is_trivially_relocatable<T>());
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::RelocateAround(T *pNew, size_type index, size_type gap, true_type)
+	{
+		ministl::uninitialized_relocate(mpBegin, mpBegin + index, pNew);
+		ministl::uninitialized_relocate(mpBegin + index, mpEnd, pNew + index + gap);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::RelocateAround(T *pNew, size_type index, size_type gap, false_type)
+	{
+		T *pMid = MoveIfNoexcept(mpBegin, mpBegin + index, pNew);
+		try
+		{
+			MoveIfNoexcept(mpBegin + index, mpEnd, pNew + index + gap);
+		}
+		catch (...)
+		{
+			ministl::destroy(pNew, pMid);
+			throw;
+		}
+		ministl::destroy(mpBegin, mpEnd);
+	}
+
+
+	// moves [first, last) to the uninitialized pDest, but copies it when the
+	// move may throw and T can be copied, as std::move_if_noexcept does.
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline T *vector<T, Allocator, GrowthPolicy>::MoveIfNoexcept(T *first, T *last, T *pDest)
+	{
+		return MoveIfNoexcept(first, last, pDest,
+		                      bool_type<!std::is_nothrow_move_constructible<T>::value &&
+		                                std::is_copy_constructible<T>::value>());
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline T *vector<T, Allocator, GrowthPolicy>::MoveIfNoexcept(T *first, T *last, T *pDest, true_type)
+	{
+		return ministl::uninitialized_copy(first, last, pDest);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline T *vector<T, Allocator, GrowthPolicy>::MoveIfNoexcept(T *first, T *last, T *pDest, false_type)
+	{
+		return ministl::uninitialized_move(first, last, pDest);
+	}
+
+
+	// frees the storage, whose elements have been relocated or destroyed.
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	inline void vector<T, Allocator, GrowthPolicy>::FreeStorage()
+	{
+		DoFree(mpBegin, capacity());
+		mpBegin = mpEnd = mpCapacity = nullptr;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	template <typename...Args>
+	void vector<T, Allocator, GrowthPolicy>::ReallocEmplace(size_type index, Args&&...args)
+	{
+		size_type count = size();
+		size_type new_capacity = GrowCapacity(count + 1);
+		T *pNew = DoAllocate(new_capacity);
+		try
+		{
+			::new(static_cast<void*>(pNew + index)) value_type(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			DoFree(pNew, new_capacity);
+			throw;
+		}
+
+		try
+		{
+			RelocateAround(pNew, index, 1);
+		}
+		catch (...)
+		{
+			pNew[index].~value_type();
+			DoFree(pNew, new_capacity);
+			throw;
+		}
+		FreeStorage();
+		mpBegin = pNew;
+		mpEnd = pNew + count + 1;
+		mpCapacity = pNew + new_capacity;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void vector<T, Allocator, GrowthPolicy>::InsertValues(size_type index, size_type n, const T &value)
+	{
+		if (n == 0)
+			return;
+
+		if (size_type(mpCapacity - mpEnd) >= n)
+		{
+			value_type copy(value);
+			T *pos = mpBegin + index;
+			size_type after = mpEnd - pos;
+			T *pOldEnd = mpEnd;
+
+			if (after > n)
+			{
+				mpEnd = ministl::uninitialized_move(mpEnd - n, mpEnd, mpEnd);
+				std::move_backward(pos, pOldEnd - n, pOldEnd);
+				std::fill(pos, pos + n, copy);
+			}
+			else
+			{
+				mpEnd = ministl::uninitialized_fill_n(mpEnd, n - after, copy);
+				mpEnd = ministl::uninitialized_move(pos, pOldEnd, mpEnd);
+				std::fill(pos, pOldEnd, copy);
+			}
+			return;
+		}
+
+		size_type count = size();
+		size_type new_capacity = GrowCapacity(count + n);
+		T *pNew = DoAllocate(new_capacity);
+		try
+		{
+			ministl::uninitialized_fill_n(pNew + index, n, value);
+		}
+		catch (...)
+		{
+			DoFree(pNew, new_capacity);
+			throw;
+		}
+
+		try
+		{
+			RelocateAround(pNew, index, n);
+		}
+		catch (...)
+		{
+			ministl::destroy(pNew + index, pNew + index + n);
+			DoFree(pNew, new_capacity);
+			throw;
+		}
+		FreeStorage();
+		mpBegin = pNew;
+		mpEnd = pNew + count + n;
+		mpCapacity = pNew + new_capacity;
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	template <typename Integer>
+	void vector<T, Allocator, GrowthPolicy>::Insert(size_type index, Integer n, Integer value, true_type)
+	{
+		InsertValues(index, static_cast<size_type>(n), static_cast<value_type>(value));
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	template <typename InputIterator>
+	void vector<T, Allocator, GrowthPolicy>::Insert(size_type index, InputIterator first, InputIterator last, false_type)
+	{
+		InsertRange(index, first, last, typename iterator_traits<InputIterator>::iterator_category());
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	template <typename InputIterator>
+	void vector<T, Allocator, GrowthPolicy>::InsertRange(size_type index, InputIterator first, InputIterator last,
+	                                                     input_iterator_tag)
+	{
+		for (; first != last; ++first, ++index)
+			emplace(mpBegin + index, *first);
+	}
+
+
+	// the size of the range is known up front, so the vector reallocates at
+	// most once.
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	template <typename ForwardIterator>
+	void vector<T, Allocator, GrowthPolicy>::InsertRange(size_type index, ForwardIterator first, ForwardIterator last,
+	                                                     forward_iterator_tag)
+	{
+		size_type n = ministl::distance(first, last);
+		if (n == 0)
+			return;
+
+		if (size_type(mpCapacity - mpEnd) >= n)
+		{
+			T *pos = mpBegin + index;
+			size_type after = mpEnd - pos;
+			T *pOldEnd = mpEnd;
+
+			if (after > n)
+			{
+				mpEnd = ministl::uninitialized_move(mpEnd - n, mpEnd, mpEnd);
+				std::move_backward(pos, pOldEnd - n, pOldEnd);
+				std::copy(first, last, pos);
+			}
+			else
+			{
+				ForwardIterator mid = first;
+				ministl::advance(mid, after);
+				mpEnd = ministl::uninitialized_copy(mid, last, mpEnd);
+				mpEnd = ministl::uninitialized_move(pos, pOldEnd, mpEnd);
+				std::copy(first, mid, pos);
+			}
+			return;
+		}
+
+		size_type count = size();
+		size_type new_capacity = GrowCapacity(count + n);
+		T *pNew = DoAllocate(new_capacity);
+		try
+		{
+			ministl::uninitialized_copy(first, last, pNew + index);
+		}
+		catch (...)
+		{
+			DoFree(pNew, new_capacity);
+			throw;
+		}
+
+		try
+		{
+			RelocateAround(pNew, index, n);
+		}
+		catch (...)
+		{
+			ministl::destroy(pNew + index, pNew + index + n);
+			DoFree(pNew, new_capacity);
+			throw;
+		}
+		FreeStorage();
+		mpBegin = pNew;
+		mpEnd = pNew + count + n;
+		mpCapacity = pNew + new_capacity;
+	}
+
+
+	// a vector only holds pointers to its elements.
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	struct is_trivially_relocatable<vector<T, Allocator, GrowthPolicy> >: true_type
+	{
+
+	};
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	bool operator==(const vector<T, Allocator, GrowthPolicy> &lhs, const vector<T, Allocator, GrowthPolicy> &rhs)
+	{
+		return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	bool operator!=(const vector<T, Allocator, GrowthPolicy> &lhs, const vector<T, Allocator, GrowthPolicy> &rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+
+	template <typename T, typename Allocator, typename GrowthPolicy>
+	void swap(vector<T, Allocator, GrowthPolicy> &lhs, vector<T, Allocator, GrowthPolicy> &rhs)
+	{
+		lhs.swap(rhs);
+	}
+}
+
+#endif